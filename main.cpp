@@ -1,11 +1,22 @@
 #include <iostream>
+#include <thread>
+#include <unistd.h>
 
 #include "./src/front/Lexer.h"
 #include "./src/front/Parser.h"
 #include "./src/front/Token.h"
 
+#include "./src/FlatAst.h"
+#include "./src/middle/Cfg.h"
+#include "./src/middle/Opt.h"
+
+#include "./src/back/Builtin.h"
+#include "./src/back/Elf.h"
+#include "./src/back/Jit.h"
 #include "./src/back/dll.h"
 
+#include "./src/vm/Bytecode.h"
+
 #define OK 0
 #define ERR 1
 
@@ -17,13 +28,14 @@ std::string shift(int &argc, char** &argv) {
     return str;
 }
 
-void print_tokens(std::vector<Token> &vl) {
+void print_tokens(TokenStream &vl) {
     std::cout << "----------------\n";
     std::cout << "DEBUG: print_tokens\n";
 
     std::cout << "len(tokens) = " << vl.size() << std::endl << std::endl;
 
-    for (auto tkn : vl) {
+    for (uint_t i = 0; i < vl.size(); i++) {
+        auto tkn = vl.token(i);
         std::cout << token_loc(tkn) << std::endl;
         std::cout << "'" << tkn.text << "'" << std::endl;
         std::cout << "type: " << ttype_str(tkn.type) << std::endl << std::endl;
@@ -32,7 +44,7 @@ void print_tokens(std::vector<Token> &vl) {
     std::cout << "----------------\n";
 }
 
-void print_parser_info(std::vector<std::unique_ptr<Instr>> &vp) {
+void print_parser_info(Instrs &vp) {
     std::cout << "----------------\n";
     std::cout << "DEBUG: print_parser_info\n";
 
@@ -43,11 +55,82 @@ void print_parser_info(std::vector<std::unique_ptr<Instr>> &vp) {
     std::cout << "----------------\n";
 }
 
+void print_cfg(Instrs &vp) {
+    std::cout << "----------------\n";
+    std::cout << "DEBUG: print_cfg\n";
+
+    // -stats only counts the program that gets compiled, not this copy.
+    auto &optimizer = Optimizer::get_optimizer();
+    auto stats = optimizer.stats;
+    auto program = optimize(vp);
+    optimizer.stats = stats;
+
+    Cfg cfg(program);
+
+    std::cout << "len(blocks) = " << cfg.blocks.size() << std::endl;
+    std::cout << "len(loops) = " << cfg.loops.size() << std::endl << std::endl;
+
+    for (uint_t b = 0; b < cfg.blocks.size(); b++) {
+        auto &block = cfg.blocks[b];
+        std::cout << "block " << b << " [" << block.first << ", " << block.end << ")";
+        if (!cfg.reachable(b)) {
+            std::cout << " unreachable" << std::endl;
+            continue;
+        }
+
+        std::cout << " idom " << cfg.idom[b] << " depth " << cfg.depth(b) << " ->";
+        for (auto succ : block.succs) std::cout << " " << succ;
+        std::cout << std::endl;
+    }
+
+    std::cout << "----------------\n";
+}
+
+void print_opt_stats() {
+    // stdout can hold the compiled program.
+    auto &stats = Optimizer::get_optimizer().stats;
+
+    std::cerr << "----------------\n";
+    std::cerr << "DEBUG: print_opt_stats\n";
+
+    std::cerr << "folded = " << stats.folded << std::endl;
+    std::cerr << "propagated = " << stats.propagated << std::endl;
+    std::cerr << "branches = " << stats.branches << std::endl;
+    std::cerr << "unreachable = " << stats.unreachable << std::endl;
+    std::cerr << "jumps = " << stats.jumps << std::endl;
+    std::cerr << "labels = " << stats.labels << std::endl;
+    std::cerr << "stores = " << stats.stores << std::endl;
+    std::cerr << "vars = " << stats.vars << std::endl;
+    std::cerr << "unrolled = " << stats.unrolled << std::endl;
+    std::cerr << "hoisted = " << stats.hoisted << std::endl;
+    std::cerr << "reduced = " << stats.reduced << std::endl;
+    std::cerr << "promoted = " << stats.promoted << std::endl;
+    std::cerr << "spilled = " << stats.spilled << std::endl;
+    for (uint_t r = 0; r < PEEP_RULE_COUNT; r++) std::cerr << "peephole " << PEEPHOLE_RULES[r].name << " = " << stats.peephole[r] << std::endl;
+
+    std::cerr << "----------------\n";
+}
+
 void usage() {
-    std::cout << "Usage: ./xtasm [options] <file>\n";
+    std::cout << "Usage: ./xtasm [options] <file | ->\n";
     std::cout << "Options:\n";
     std::cout << "\t-dbgl: debug the tokens\n";
     std::cout << "\t-dbgp: debug the parser info\n";
+    std::cout << "\t-dbgc: debug the control flow graph\n";
+    std::cout << "\t-par: lex the file in parallel\n";
+    std::cout << "\t-stream: parse the tokens while the file is lexed\n";
+    std::cout << "\t-flat: rebuild the syntax tree from its flat form\n";
+    std::cout << "\t-O: optimize the lowered program (native targets and -vm)\n";
+    std::cout << "\t-unroll <n>: copies of the body of a counted loop with -O (default: 4, 1 turns it off)\n";
+    std::cout << "\t-stats: print what -O removed (on stderr)\n";
+    std::cout << "\t-target <name>: pick a built-in backend (default: template)\n";
+    std::cout << "\t-plugin <path>: use a backend plugin instead of a built-in one\n";
+    std::cout << "\t-o <file>: write a native x86-64 executable (an object file if it ends with '.o')\n";
+    std::cout << "\t-run: run the program in-process, exiting with the value of Exit\n";
+    std::cout << "\t-vm: run the program on the bytecode interpreter, exiting with the value of Exit\n";
+    std::cout << "\t-vmprof: like -vm without superinstructions, writing the most executed pairs of opcodes\n";
+    std::cout << "Targets:\n";
+    for (auto &backend : BUILTINS) std::cout << "\t" << backend.name << "\n";
 }
 
 int main(int argc, char** argv) {
@@ -64,6 +147,17 @@ int main(int argc, char** argv) {
 
     bool debug_tkns = false;
     bool debug_parser = false;
+    bool debug_cfg = false;
+    bool stats = false;
+    bool parallel = false;
+    bool stream = false;
+    bool flat = false;
+    std::string target = "template";
+    std::string plugin;
+    std::string output;
+    bool run = false;
+    bool vm = false;
+    bool vm_profile = false;
 
     std::string arg;
     do {
@@ -74,17 +168,101 @@ int main(int argc, char** argv) {
         }
         else if (arg == "-dbgl") debug_tkns = true;
         else if (arg == "-dbgp") debug_parser = true;
+        else if (arg == "-dbgc") debug_cfg = true;
+        else if (arg == "-par") parallel = true;
+        else if (arg == "-stream") stream = true;
+        else if (arg == "-flat") flat = true;
+        else if (arg == "-O") Optimizer::get_optimizer().enabled = true;
+        else if (arg == "-unroll") Optimizer::get_optimizer().unroll = std::max(std::atoll(shift(argc, argv).c_str()), 1LL);
+        else if (arg == "-stats") stats = true;
+        else if (arg == "-target") target = shift(argc, argv);
+        else if (arg == "-plugin") plugin = shift(argc, argv);
+        else if (arg == "-o") output = shift(argc, argv);
+        else if (arg == "-run") run = true;
+        else if (arg == "-vm") vm = true;
+        else if (arg == "-vmprof") vm_profile = true;
     } while(argc > 0 && arg.starts_with("-"));
 
-    auto file = "./example/" + arg;
-    auto vl = l.lex_file(file);
-    auto vp = p.parse_tkns(vl);
+    // "-" reads the program from stdin.
+    auto file = arg == "-" ? arg : "./example/" + arg;
+    // checking the backend before doing any work.
+    auto builtin = find_builtin(target);
+    if (plugin.empty() && !builtin) {
+        usage();
+        crash("Unknown target '" + target + "'.");
+    }
+
+    // the whole syntax tree lives inside the arena of the context.
+    Ast ast;
+    Arena::Scope scope(ast.arena);
+    auto &vp = ast.instructions;
+
+    if (stream) {
+        // the tokens never exist all together, only the parser window does.
+        TokenPipe pipe;
+        std::thread lexer([&] { l.lex_stream(file, pipe); });
+        vp = p.parse_stream(pipe, lexer);
+
+        if (debug_tkns) log("Tokens are not kept with -stream.");
+    } else {
+        auto vl = parallel ? l.lex_file_parallel(file) : l.lex_file(file);
+        if (debug_tkns) print_tokens(vl);
+
+        vp = p.parse_tkns(std::move(vl));
+    }
+
+    if (flat) {
+        auto fa = Flat_Ast::flatten(vp);
+        vp = fa.unflatten();
+
+        if (debug_parser) log("len(flat nodes) = " + std::to_string(fa.nodes.size()));
+    }
 
-    if (debug_tkns) print_tokens(vl);
     if (debug_parser) print_parser_info(vp);
+    if (debug_cfg) print_cfg(vp);
+
+    // the statistics come once the backend is done.
+    auto status = [&]() -> int {
+        if (run) {
+            // same exit status as the native executable.
+            return run_jit(vp);
+        }
+
+        if (vm) return run_bytecode(vp);
+        if (vm_profile) {
+            std::cout.flush();
+            Fd_Sink out(STDOUT_FILENO);
+            return profile_bytecode(vp, out);
+        }
+
+        if (!output.empty()) {
+            // no assembler or linker needed.
+            bool object = output.ends_with(".o");
+            File_Sink out(output, object ? 0644 : 0755);
+            compile_elf(vp, object ? Elf_Kind::OBJECT : Elf_Kind::EXEC, out);
+
+            return OK;
+        }
+
+        // the debug output has to come before the code.
+        std::cout.flush();
+        Fd_Sink out(STDOUT_FILENO);
+
+        if (plugin.empty()) {
+            builtin->compile(vp, out);
+        } else if (Backend_Registry::get_registry().lowered(plugin)) {
+            // the plugin asked for the lowered program (optimized with -O).
+            compile(plugin, optimize(vp), out);
+        } else {
+            // plugins get the flat form of the program.
+            auto program = Flat_Ast::flatten(vp);
+            compile(plugin, program, out);
+        }
 
-    std::cout << compile("./build/libtemplate.so", vp);
+        return OK;
+    }();
 
-    return OK;
+    if (stats) print_opt_stats();
+    return status;
 }
 
@@ -0,0 +1,269 @@
+#include "FlatAst.h"
+
+Flat_Ast::Flat_Ast() {
+    // id 0 is always the empty string.
+    this->intern("");
+}
+
+uint32_t Flat_Ast::intern(std::string_view str) {
+    auto it = this->ids.find(str);
+    if (it != this->ids.end()) return it->second;
+
+    // the key has to point inside the pool, not inside the caller string.
+    auto id = (uint32_t) this->strings.size();
+    this->strings.emplace_back(str);
+    this->ids.emplace(this->strings.back(), id);
+
+    return id;
+}
+
+uint32_t Flat_Ast::reserve(uint32_t count) {
+    auto first = (uint32_t) this->nodes.size();
+    this->nodes.resize(first + count);
+    return first;
+}
+
+Flat_Ast Flat_Ast::flatten(const Instrs &instructions) {
+    Flat_Ast ast;
+
+    ast.top = instructions.size();
+    ast.fill(ast.reserve(ast.top), instructions);
+
+    return ast;
+}
+
+void Flat_Ast::fill(uint32_t index, const Instrs &instrs) {
+    for (auto &instr : instrs) this->fill(index++, instr.get());
+}
+
+void Flat_Ast::fill(uint32_t index, const Instr *instr) {
+    if (!instr) crash("Unable to flatten an incomplete syntax tree.\n");
+
+    // the node is written at the end, 'nodes' grows while the children are filled.
+    Flat_Node node = { instr->kind(), 0, 0, 0, 0, 0, 0, 0 };
+
+    // Used to fill the two operands of a node.
+    auto operands = [&](const Instr *lhs, const Instr *rhs) {
+        node.count = 2;
+        node.first = this->reserve(node.count);
+        this->fill(node.first, lhs);
+        this->fill(node.first + 1, rhs);
+    };
+
+    switch (node.kind) {
+        case Instr_Kind::DATA: {
+            auto &variables = ((const Data *) instr)->variables;
+            node.count = variables.size();
+            node.first = this->reserve(node.count);
+            this->fill(node.first, variables);
+        } break;
+
+        case Instr_Kind::CODE: {
+            auto &instructions = ((const Code *) instr)->instructions;
+            node.count = instructions.size();
+            node.first = this->reserve(node.count);
+            this->fill(node.first, instructions);
+        } break;
+
+        case Instr_Kind::LABEL:
+            node.value = this->intern(((const Label *) instr)->name);
+            break;
+
+        case Instr_Kind::EXIT:
+            node.count = 1;
+            node.first = this->reserve(node.count);
+            this->fill(node.first, ((const Exit *) instr)->exit_value.get());
+            break;
+
+        case Instr_Kind::ADD:
+            operands(((const Add *) instr)->dst.get(), ((const Add *) instr)->src.get());
+            break;
+
+        case Instr_Kind::SUB:
+            operands(((const Sub *) instr)->dst.get(), ((const Sub *) instr)->src.get());
+            break;
+
+        case Instr_Kind::MUL:
+            operands(((const Mul *) instr)->dst.get(), ((const Mul *) instr)->src.get());
+            break;
+
+        case Instr_Kind::MOV:
+            operands(((const Mov *) instr)->dst.get(), ((const Mov *) instr)->src.get());
+            break;
+
+        case Instr_Kind::JMP:
+            node.count = 1;
+            node.first = this->reserve(node.count);
+            this->fill(node.first, ((const Jmp *) instr)->target.get());
+            break;
+
+        case Instr_Kind::BREAK:
+            break;
+
+        case Instr_Kind::ENUM: {
+            auto enm = (const Enum_Var *) instr;
+            node.value = this->intern(enm->name);
+            node.count = enm->values.size();
+            node.first = this->reserve(node.count);
+            this->fill(node.first, enm->values);
+        } break;
+
+        case Instr_Kind::WHILE: {
+            auto loop = (const While *) instr;
+            node.value = loop->conditions.size();
+            node.count = loop->conditions.size() + loop->body.size();
+            node.first = this->reserve(node.count);
+            this->fill(node.first, loop->conditions);
+            this->fill(node.first + node.value, loop->body);
+
+            for (uint_t i = 0; i < loop->bool_ops.size(); i++) {
+                this->nodes[node.first + i + 1].link = loop->bool_ops[i];
+            }
+        } break;
+
+        case Instr_Kind::FOR: {
+            auto loop = (const For *) instr;
+            node.count = 3 + loop->body.size();
+            node.first = this->reserve(node.count);
+            this->fill(node.first, loop->range_left.get());
+            this->fill(node.first + 1, loop->range_right.get());
+            this->fill(node.first + 2, loop->increment.get());
+            this->fill(node.first + 3, loop->body);
+        } break;
+
+        case Instr_Kind::LOOP: {
+            auto &body = ((const Loop *) instr)->body;
+            node.count = body.size();
+            node.first = this->reserve(node.count);
+            this->fill(node.first, body);
+        } break;
+
+        case Instr_Kind::IF: {
+            auto branch = (const If *) instr;
+            node.value = branch->conditions.size();
+            node.extra = branch->if_body.size();
+            node.count = node.value + node.extra + branch->else_body.size();
+            node.first = this->reserve(node.count);
+            this->fill(node.first, branch->conditions);
+            this->fill(node.first + node.value, branch->if_body);
+            this->fill(node.first + node.value + node.extra, branch->else_body);
+
+            for (uint_t i = 0; i < branch->bool_ops.size(); i++) {
+                this->nodes[node.first + i + 1].link = branch->bool_ops[i];
+            }
+        } break;
+
+        case Instr_Kind::COND: {
+            auto cond = (const Cond *) instr;
+            node.op = cond->op;
+            operands(cond->lhs.get(), cond->rhs.get());
+        } break;
+
+        case Instr_Kind::VAR: {
+            auto var = (const Var *) instr;
+            node.op = var->is_decl;
+            node.value = this->intern(var->name);
+            node.extra = this->intern(var->value);
+        } break;
+
+        case Instr_Kind::TXT:
+            node.value = this->intern(((const Txt *) instr)->value);
+            break;
+    }
+
+    this->nodes[index] = node;
+}
+
+Instrs Flat_Ast::unflatten() const {
+    return this->build(this->program());
+}
+
+Instrs Flat_Ast::build(std::span<const Flat_Node> nodes) const {
+    Instrs instrs;
+    instrs.reserve(nodes.size());
+
+    for (auto &node : nodes) instrs.push_back(this->build(node));
+
+    return instrs;
+}
+
+std::unique_ptr<Instr> Flat_Ast::build(const Flat_Node &node) const {
+    auto children = this->children(node);
+
+    switch (node.kind) {
+        case Instr_Kind::DATA:
+            return std::make_unique<Data>(this->build(children));
+
+        case Instr_Kind::CODE:
+            return std::make_unique<Code>(this->build(children));
+
+        case Instr_Kind::LABEL:
+            return std::make_unique<Label>(this->str(node.value));
+
+        case Instr_Kind::EXIT:
+            return std::make_unique<Exit>(this->build(children[0]));
+
+        case Instr_Kind::ADD:
+            return std::make_unique<Add>(this->build(children[0]), this->build(children[1]));
+
+        case Instr_Kind::SUB:
+            return std::make_unique<Sub>(this->build(children[0]), this->build(children[1]));
+
+        case Instr_Kind::MUL:
+            return std::make_unique<Mul>(this->build(children[0]), this->build(children[1]));
+
+        case Instr_Kind::MOV:
+            return std::make_unique<Mov>(this->build(children[0]), this->build(children[1]));
+
+        case Instr_Kind::JMP:
+            return std::make_unique<Jmp>(this->build(children[0]));
+
+        case Instr_Kind::BREAK:
+            return std::make_unique<Break>();
+
+        case Instr_Kind::ENUM:
+            return std::make_unique<Enum_Var>(this->str(node.value), this->build(children));
+
+        case Instr_Kind::WHILE: {
+            auto conditions = children.first(node.value);
+
+            Bool_Ops bool_ops;
+            for (uint_t i = 1; i < conditions.size(); i++) bool_ops.push_back((Bool_Op) conditions[i].link);
+
+            return std::make_unique<While>(this->build(conditions), bool_ops, this->build(children.subspan(node.value)));
+        }
+
+        case Instr_Kind::FOR:
+            return std::make_unique<For>(this->build(children[0]),
+                                         this->build(children[1]),
+                                         this->build(children[2]),
+                                         this->build(children.subspan(3)));
+
+        case Instr_Kind::LOOP:
+            return std::make_unique<Loop>(this->build(children));
+
+        case Instr_Kind::IF: {
+            auto conditions = children.first(node.value);
+
+            Bool_Ops bool_ops;
+            for (uint_t i = 1; i < conditions.size(); i++) bool_ops.push_back((Bool_Op) conditions[i].link);
+
+            return std::make_unique<If>(this->build(conditions),
+                                        bool_ops,
+                                        this->build(children.subspan(node.value, node.extra)),
+                                        this->build(children.subspan(node.value + node.extra)));
+        }
+
+        case Instr_Kind::COND:
+            return std::make_unique<Cond>((Cond_Op) node.op, this->build(children[0]), this->build(children[1]));
+
+        case Instr_Kind::VAR:
+            return std::make_unique<Var>(this->str(node.value), this->str(node.extra), node.op);
+
+        case Instr_Kind::TXT:
+            return std::make_unique<Txt>(this->str(node.value));
+    }
+
+    crash("Invalid node inside the flat syntax tree.\n");
+    return nullptr;
+}
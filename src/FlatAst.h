@@ -0,0 +1,94 @@
+#ifndef FLATAST_H
+#define FLATAST_H
+
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "InstructionSet.h"
+
+// Node of the flat syntax tree.
+// Every node has the same size, the children of a node are stored
+// one after the other so they can be walked as a range.
+// Layout of the children:
+//  - DATA, CODE, ENUM, LOOP: the list of instructions.
+//  - EXIT, JMP: the value.
+//  - ADD, SUB, MUL, MOV: dst, src.
+//  - COND: lhs, rhs.
+//  - WHILE: the 'split' conditions, then the body.
+//  - FOR: range_left, range_right, increment, then the body.
+//  - IF: the 'split' conditions, the 'extra' instructions of the if body, then the else body.
+struct Flat_Node {
+    Instr_Kind kind;
+    // Cond_Op of a COND, is_decl of a VAR.
+    uint8_t op;
+    // Bool_Op joining a COND with the previous condition (ignored for the first one).
+    uint8_t link;
+    uint8_t unused;
+    // index of the first child.
+    uint32_t first;
+    // number of children.
+    uint32_t count;
+    // string of LABEL, ENUM, VAR (name) and TXT, split of the children for WHILE and IF.
+    uint32_t value;
+    // string of VAR (value), length of the if body for IF.
+    uint32_t extra;
+};
+
+// Syntax tree stored as one contiguous array of nodes.
+// Names and literals are interned inside a pool and addressed by 32 bit ids.
+class Flat_Ast {
+    public:
+        // Default c'tor.
+        explicit Flat_Ast();
+        // Deleting copy c'tor (the pool lookup table points into the pool).
+        explicit Flat_Ast(const Flat_Ast &other) = delete;
+        // Move c'tor.
+        Flat_Ast(Flat_Ast &&other) = default;
+
+        // Used to craft the flat form of a syntax tree.
+        static Flat_Ast flatten(const Instrs &instructions);
+        // Used to craft back the syntax tree, the nodes come from the default pmr resource.
+        Instrs unflatten() const;
+
+        // Used to get the id of a string, adding it to the pool if missing.
+        uint32_t intern(std::string_view str);
+        // Used to get the string of an id.
+        std::string_view str(uint32_t id) const { return this->strings[id]; }
+        // Used to get the number of strings inside the pool.
+        uint32_t pool_size() const { return this->strings.size(); }
+
+        // Used to walk the top level instructions.
+        std::span<const Flat_Node> program() const { return { this->nodes.data(), this->top }; }
+        // Used to walk the children of a node.
+        std::span<const Flat_Node> children(const Flat_Node &node) const { return { this->nodes.data() + node.first, node.count }; }
+
+        // every node, the top level instructions first.
+        std::vector<Flat_Node> nodes;
+        // number of top level instructions.
+        uint32_t top = 0;
+
+    private:
+        // Used to reserve room for count consecutive nodes.
+        uint32_t reserve(uint32_t count);
+        // Used to fill the node at index (and its children).
+        void fill(uint32_t index, const Instr *instr);
+        // Used to fill count consecutive nodes starting from index.
+        void fill(uint32_t index, const Instrs &instrs);
+
+        // Used to craft back a single node.
+        std::unique_ptr<Instr> build(const Flat_Node &node) const;
+        // Used to craft back a range of nodes.
+        Instrs build(std::span<const Flat_Node> nodes) const;
+
+        // storage of the strings, a deque never moves them around.
+        std::deque<std::string> strings;
+        // lookup table used to intern the strings.
+        std::unordered_map<std::string_view, uint32_t> ids;
+};
+
+#endif // FLATAST_H
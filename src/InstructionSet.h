@@ -1,16 +1,26 @@
 #ifndef INSTRUCTIONSET_H
 #define INSTRUCTIONSET_H
 
+#include "shared/Arena.h"
 #include "shared/Basic.h"
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <memory_resource>
+#include <span>
 #include <vector>
 #include <string>
+#include <string_view>
 
 // Forward declaration for the Visitor class.
 class Instr;
 
+// List of instructions, allocated from the default pmr resource
+// (see Arena and Ast).
+using Instrs = std::pmr::vector<std::unique_ptr<Instr>>;
+
 enum Bool_Op {
     // &&
     BAND,
@@ -18,12 +28,53 @@ enum Bool_Op {
     BOR,
 };
 
+// List of boolean operators.
+using Bool_Ops = std::pmr::vector<Bool_Op>;
+
+// Enum representing the condition operations.
+enum Cond_Op {
+    // ==
+    EQU,
+    // !=
+    NEQU,
+    // <
+    LTH,
+    // <=
+    LTE,
+    // >
+    GT,
+    // >=
+    GTE,
+};
+
+// Enum mirroring the subclasses of Instr.
+enum class Instr_Kind : uint8_t {
+    DATA,
+    CODE,
+    LABEL,
+    EXIT,
+    ADD,
+    SUB,
+    MUL,
+    MOV,
+    JMP,
+    BREAK,
+    ENUM,
+    WHILE,
+    FOR,
+    LOOP,
+    IF,
+    COND,
+    VAR,
+    TXT,
+};
+
 // Design Pattern: Visitor.
 class Visitor {
     public:
         // TODO: make these pure virtual methods.
-        virtual std::string compile_data(std::vector<std::unique_ptr<Instr>> variables) { return ""; } 
-        virtual std::string compile_code(std::vector<std::unique_ptr<Instr>> instructions) { return ""; } 
+        virtual std::string compile_data(Instrs variables) { return ""; } 
+        virtual std::string compile_code(Instrs instructions) { return ""; } 
         virtual std::string compile_label(std::string name) { return ""; }
         virtual std::string compile_exit(std::string value) { return ""; }
         virtual std::string compile_add(std::string dst, std::string src) { return ""; }
@@ -32,15 +83,15 @@ class Visitor {
         virtual std::string compile_mov(std::string dst, std::string src) { return ""; }
         virtual std::string compile_jmp(std::string target) { return ""; }
         virtual std::string compile_break() { return ""; }
-        virtual std::string compile_enum(std::vector<std::unique_ptr<Instr>> values) { return ""; }
-        virtual std::string compile_while(std::vector<std::unique_ptr<Instr>> conditions, 
-                                          std::vector<Bool_Op> bool_ops, 
-                                          std::vector<std::unique_ptr<Instr>> body) { return ""; }
+        virtual std::string compile_enum(Instrs values) { return ""; }
+        virtual std::string compile_while(Instrs conditions, 
+                                          Bool_Ops bool_ops, 
+                                          Instrs body) { return ""; }
         virtual std::string compile_for(std::unique_ptr<Instr> range_left, 
                                         std::unique_ptr<Instr> range_right,
                                         std::unique_ptr<Instr> increment,
-                                        std::vector<std::unique_ptr<Instr>> body) { return ""; }
-        virtual std::string compile_loop(std::vector<std::unique_ptr<Instr>> body) { return ""; }
+                                        Instrs body) { return ""; }
+        virtual std::string compile_loop(Instrs body) { return ""; }
         virtual std::string compile_var(std::string name, std::string value, bool is_decl) { return ""; }
 
     protected:
@@ -51,49 +102,128 @@ class Visitor {
         std::string current_loop = "";
 };
 
+// Read-only view over a list of instructions.
+using Instrs_View = std::span<const std::unique_ptr<Instr>>;
+
+// Design Pattern: Visitor (read-only).
+// Unlike Visitor nothing is moved out of the tree, so the same tree can be
+// visited again by an other pass or backend.
+// By default every method just visits the children.
+class Const_Visitor {
+    public:
+        virtual ~Const_Visitor() = default;
+
+        // Used to visit a list of instructions in order.
+        void visit(Instrs_View instrs);
+
+        virtual void visit_data(Instrs_View variables) { this->visit(variables); }
+        virtual void visit_code(Instrs_View instructions) { this->visit(instructions); }
+        virtual void visit_label(std::string_view name) {}
+        virtual void visit_exit(const Instr &value);
+        virtual void visit_add(const Instr &dst, const Instr &src);
+        virtual void visit_sub(const Instr &dst, const Instr &src);
+        virtual void visit_mul(const Instr &dst, const Instr &src);
+        virtual void visit_mov(const Instr &dst, const Instr &src);
+        virtual void visit_jmp(const Instr &target);
+        virtual void visit_break() {}
+        virtual void visit_enum(std::string_view name, Instrs_View values) { this->visit(values); }
+        virtual void visit_while(Instrs_View conditions, 
+                                 std::span<const Bool_Op> bool_ops, 
+                                 Instrs_View body);
+        virtual void visit_for(const Instr &range_left, 
+                               const Instr &range_right,
+                               const Instr &increment,
+                               Instrs_View body);
+        virtual void visit_loop(Instrs_View body) { this->visit(body); }
+        virtual void visit_if(Instrs_View conditions,
+                              std::span<const Bool_Op> bool_ops,
+                              Instrs_View if_body,
+                              Instrs_View else_body);
+        virtual void visit_cond(Cond_Op op, const Instr &lhs, const Instr &rhs);
+        virtual void visit_var(std::string_view name, std::string_view value, bool is_decl) {}
+        virtual void visit_txt(std::string_view value) {}
+};
+
 // Instruction set.
 class Instr {
     public:
         virtual ~Instr() = default;
 
+        // Nodes are allocated from the default pmr resource, so a Parser running
+        // inside an Arena::Scope builds the whole tree inside the arena.
+        // The resource is saved in front of the node to free it correctly.
+        static void *operator new(std::size_t size) {
+            auto resource = std::pmr::get_default_resource();
+            auto ptr = (char *) resource->allocate(size + NODE_HEADER, NODE_HEADER);
+            *(std::pmr::memory_resource **) ptr = resource;
+            return ptr + NODE_HEADER;
+        }
+        static void operator delete(void *ptr, std::size_t size) {
+            auto base = (char *) ptr - NODE_HEADER;
+            auto resource = *(std::pmr::memory_resource **) base;
+            resource->deallocate(base, size + NODE_HEADER, NODE_HEADER);
+        }
+
+        // Used to know the subclass without dynamic casts.
+        virtual Instr_Kind kind() const = 0;
+
+        // Used to visit the node without modifying it.
+        virtual void accept(Const_Visitor &v) const = 0;
+
         // TODO: make this a pure virtual method.
         virtual std::string compile(Visitor &v) { 
             crash("If you see this message it means that there is an error inside the Parser.\n");
             return ""; 
         };
+
+    private:
+        // space reserved in front of every node.
+        static constexpr std::size_t NODE_HEADER = alignof(std::max_align_t);
 };
 
 class Data : public Instr {
     public:
-        explicit Data(std::vector<std::unique_ptr<Instr>> variables) : variables(std::move(variables)) {} 
+        explicit Data(Instrs variables) : variables(std::move(variables)) {} 
+
+        Instr_Kind kind() const { return Instr_Kind::DATA; }
+        void accept(Const_Visitor &v) const { v.visit_data(this->variables); }
 
         std::string compile(Visitor &v) { return v.compile_data(std::move(this->variables)); }
 
-        std::vector<std::unique_ptr<Instr>> variables;
+        Instrs variables;
 };
 
 class Code : public Instr {
     public:
-        explicit Code(std::vector<std::unique_ptr<Instr>> instructions) : instructions(std::move(instructions)) {} 
+        explicit Code(Instrs instructions) : instructions(std::move(instructions)) {} 
+
+        Instr_Kind kind() const { return Instr_Kind::CODE; }
+        void accept(Const_Visitor &v) const { v.visit_code(this->instructions); }
 
         std::string compile(Visitor &v) { return v.compile_code(std::move(this->instructions)); }
 
-        std::vector<std::unique_ptr<Instr>> instructions;
+        Instrs instructions;
 };
 
 class Label : public Instr {
     public:
-        explicit Label(std::string name) : name(name) {}
+        explicit Label(std::string_view name) : name(name) {}
 
-        std::string compile(Visitor &v) { return v.compile_label(this->name); }
+        Instr_Kind kind() const { return Instr_Kind::LABEL; }
+        void accept(Const_Visitor &v) const { v.visit_label(this->name); }
 
-        std::string name;
+        std::string compile(Visitor &v) { return v.compile_label(std::string(this->name)); }
+
+        std::pmr::string name;
 };
 
 class Exit : public Instr {
     public:
         explicit Exit(std::unique_ptr<Instr> exit_value) : exit_value(std::move(exit_value)) {}
 
+        Instr_Kind kind() const { return Instr_Kind::EXIT; }
+        void accept(Const_Visitor &v) const { v.visit_exit(*this->exit_value); }
+
         std::string compile(Visitor &v) { return v.compile_exit(this->exit_value->compile(v)); }
 
         std::unique_ptr<Instr> exit_value;
@@ -103,6 +233,9 @@ class Add : public Instr {
     public:
         explicit Add(std::unique_ptr<Instr> dst, std::unique_ptr<Instr> src) : dst(std::move(dst)), src(std::move(src)) {}
 
+        Instr_Kind kind() const { return Instr_Kind::ADD; }
+        void accept(Const_Visitor &v) const { v.visit_add(*this->dst, *this->src); }
+
         std::string compile(Visitor &v) { return v.compile_add(this->dst->compile(v), this->src->compile(v)); }
 
         std::unique_ptr<Instr> dst;
@@ -113,6 +246,9 @@ class Sub : public Instr {
     public:
         explicit Sub(std::unique_ptr<Instr> dst, std::unique_ptr<Instr> src) : dst(std::move(dst)), src(std::move(src)) {}
 
+        Instr_Kind kind() const { return Instr_Kind::SUB; }
+        void accept(Const_Visitor &v) const { v.visit_sub(*this->dst, *this->src); }
+
         std::string compile(Visitor &v) { return v.compile_sub(this->dst->compile(v), this->src->compile(v)); }
 
         std::unique_ptr<Instr> dst;
@@ -123,6 +259,9 @@ class Mul : public Instr {
     public:
         explicit Mul(std::unique_ptr<Instr> dst, std::unique_ptr<Instr> src) : dst(std::move(dst)), src(std::move(src)) {}
 
+        Instr_Kind kind() const { return Instr_Kind::MUL; }
+        void accept(Const_Visitor &v) const { v.visit_mul(*this->dst, *this->src); }
+
         std::string compile(Visitor &v) { return v.compile_mul(this->dst->compile(v), this->src->compile(v)); }
 
         std::unique_ptr<Instr> dst;
@@ -133,6 +272,9 @@ class Mov : public Instr {
     public:
         explicit Mov(std::unique_ptr<Instr> dst, std::unique_ptr<Instr> src) : dst(std::move(dst)), src(std::move(src)) {}
 
+        Instr_Kind kind() const { return Instr_Kind::MOV; }
+        void accept(Const_Visitor &v) const { v.visit_mov(*this->dst, *this->src); }
+
         std::string compile(Visitor &v) { return v.compile_mov(this->dst->compile(v), this->src->compile(v)); }
 
         std::unique_ptr<Instr> dst;
@@ -143,6 +285,9 @@ class Jmp : public Instr {
     public:
         explicit Jmp(std::unique_ptr<Instr> target) : target(std::move(target)) {}
 
+        Instr_Kind kind() const { return Instr_Kind::JMP; }
+        void accept(Const_Visitor &v) const { v.visit_jmp(*this->target); }
+
         std::string compile(Visitor &v) { return v.compile_jmp(this->target->compile(v)); }
 
         std::unique_ptr<Instr> target;
@@ -152,33 +297,42 @@ class Break : public Instr {
     public:
         explicit Break() {}
 
+        Instr_Kind kind() const { return Instr_Kind::BREAK; }
+        void accept(Const_Visitor &v) const { v.visit_break(); }
+
         std::string compile(Visitor &v) { return v.compile_break(); }
 };
 
 class Enum_Var : public Instr {
     public:
-        explicit Enum_Var(std::string name, std::vector<std::unique_ptr<Instr>> values) : name(name), values(std::move(values)) {}
+        explicit Enum_Var(std::string_view name, Instrs values) : name(name), values(std::move(values)) {}
+
+        Instr_Kind kind() const { return Instr_Kind::ENUM; }
+        void accept(Const_Visitor &v) const { v.visit_enum(this->name, this->values); }
 
         std::string compile(Visitor &v) { return v.compile_enum(std::move(this->values)); }
 
-        std::string name;
-        std::vector<std::unique_ptr<Instr>> values;
+        std::pmr::string name;
+        Instrs values;
 };
 
 class While : public Instr {
     public:
-        explicit While(std::vector<std::unique_ptr<Instr>> conditions, 
-                       std::vector<Bool_Op> bool_ops, 
-                       std::vector<std::unique_ptr<Instr>> body) 
+        explicit While(Instrs conditions, 
+                       Bool_Ops bool_ops, 
+                       Instrs body) 
             : conditions(std::move(conditions)), 
               bool_ops(bool_ops), 
               body(std::move(body)) {}
 
+        Instr_Kind kind() const { return Instr_Kind::WHILE; }
+        void accept(Const_Visitor &v) const { v.visit_while(this->conditions, this->bool_ops, this->body); }
+
         std::string compile(Visitor &v) { return v.compile_while(std::move(conditions), std::move(bool_ops), std::move(body)); }
 
-        std::vector<std::unique_ptr<Instr>> conditions;
-        std::vector<Bool_Op> bool_ops;
-        std::vector<std::unique_ptr<Instr>> body;
+        Instrs conditions;
+        Bool_Ops bool_ops;
+        Instrs body;
 };
 
 class For : public Instr {
@@ -186,12 +340,15 @@ class For : public Instr {
         explicit For(std::unique_ptr<Instr> range_left, 
                      std::unique_ptr<Instr> range_right,
                      std::unique_ptr<Instr> increment,
-                     std::vector<std::unique_ptr<Instr>> body) 
+                     Instrs body) 
             : range_left(std::move(range_left)), 
               range_right(std::move(range_right)), 
               increment(std::move(increment)), 
               body(std::move(body)) {}
 
+        Instr_Kind kind() const { return Instr_Kind::FOR; }
+        void accept(Const_Visitor &v) const { v.visit_for(*this->range_left, *this->range_right, *this->increment, this->body); }
+
         std::string compile(Visitor &v) { return v.compile_for(std::move(range_left), 
                                                                std::move(range_right), 
                                                                std::move(increment), 
@@ -200,56 +357,49 @@ class For : public Instr {
         std::unique_ptr<Instr> range_left;
         std::unique_ptr<Instr> range_right;
         std::unique_ptr<Instr> increment;
-        std::vector<std::unique_ptr<Instr>> body;
+        Instrs body;
 };
 
 class Loop : public Instr {
     public:
-        explicit Loop(std::vector<std::unique_ptr<Instr>> body) : body(std::move(body)) {}
+        explicit Loop(Instrs body) : body(std::move(body)) {}
+
+        Instr_Kind kind() const { return Instr_Kind::LOOP; }
+        void accept(Const_Visitor &v) const { v.visit_loop(this->body); }
 
         std::string compile(Visitor &v) { return v.compile_loop(std::move(this->body)); }
 
-        std::vector<std::unique_ptr<Instr>> body;
+        Instrs body;
 };
 
 // if visitor is in charge of handling the jumps between labels. 
 class If : public Instr {
     public:
-        explicit If(std::vector<std::unique_ptr<Instr>> conditions,
-                    std::vector<Bool_Op> bool_ops,
-                    std::vector<std::unique_ptr<Instr>> if_body, 
-                    std::vector<std::unique_ptr<Instr>> else_body) 
+        explicit If(Instrs conditions,
+                    Bool_Ops bool_ops,
+                    Instrs if_body, 
+                    Instrs else_body) 
             : conditions(std::move(conditions)), 
               bool_ops(bool_ops),
               if_body(std::move(if_body)), 
               else_body(std::move(else_body)) {}
 
-        std::vector<std::unique_ptr<Instr>> conditions;
-        std::vector<Bool_Op> bool_ops;
-        std::vector<std::unique_ptr<Instr>> if_body;
-        std::vector<std::unique_ptr<Instr>> else_body;
-};
+        Instr_Kind kind() const { return Instr_Kind::IF; }
+        void accept(Const_Visitor &v) const { v.visit_if(this->conditions, this->bool_ops, this->if_body, this->else_body); }
 
-// Enum representing the condition operations.
-enum Cond_Op {
-    // ==
-    EQU,
-    // !=
-    NEQU,
-    // <
-    LTH,
-    // <=
-    LTE,
-    // >
-    GT,
-    // >=
-    GTE,
+        Instrs conditions;
+        Bool_Ops bool_ops;
+        Instrs if_body;
+        Instrs else_body;
 };
 
 class Cond : public Instr {
     public:
         explicit Cond(Cond_Op op, std::unique_ptr<Instr> lhs, std::unique_ptr<Instr> rhs) : op(op), lhs(std::move(lhs)), rhs(std::move(rhs)) {}
 
+        Instr_Kind kind() const { return Instr_Kind::COND; }
+        void accept(Const_Visitor &v) const { v.visit_cond(this->op, *this->lhs, *this->rhs); }
+
         Cond_Op op;
         std::unique_ptr<Instr> lhs;
         std::unique_ptr<Instr> rhs;
@@ -257,22 +407,75 @@ class Cond : public Instr {
 
 class Var : public Instr {
     public:
-        explicit Var(std::string name, std::string value, bool is_decl) : name(name), value(value), is_decl(is_decl) {}
+        explicit Var(std::string_view name, std::string_view value, bool is_decl) : name(name), value(value), is_decl(is_decl) {}
 
-        std::string compile(Visitor &v) { return v.compile_var(this->name, this->value, this->is_decl); }
+        Instr_Kind kind() const { return Instr_Kind::VAR; }
+        void accept(Const_Visitor &v) const { v.visit_var(this->name, this->value, this->is_decl); }
 
-        std::string name;
-        std::string value;
+        std::string compile(Visitor &v) { return v.compile_var(std::string(this->name), std::string(this->value), this->is_decl); }
+
+        std::pmr::string name;
+        std::pmr::string value;
         bool is_decl = true;
 };
 
 class Txt : public Instr {
     public:
-        explicit Txt(std::string txt) : value(txt) {}
+        explicit Txt(std::string_view txt) : value(txt) {}
+
+        Instr_Kind kind() const { return Instr_Kind::TXT; }
+        void accept(Const_Visitor &v) const { v.visit_txt(this->value); }
 
-        std::string compile(Visitor &v) { return this->value; }
+        std::string compile(Visitor &v) { return std::string(this->value); }
 
-        std::string value;
+        std::pmr::string value;
+};
+
+inline void Const_Visitor::visit(Instrs_View instrs) {
+    for (auto &instr : instrs) instr->accept(*this);
+}
+
+inline void Const_Visitor::visit_exit(const Instr &value) { value.accept(*this); }
+inline void Const_Visitor::visit_add(const Instr &dst, const Instr &src) { dst.accept(*this); src.accept(*this); }
+inline void Const_Visitor::visit_sub(const Instr &dst, const Instr &src) { dst.accept(*this); src.accept(*this); }
+inline void Const_Visitor::visit_mul(const Instr &dst, const Instr &src) { dst.accept(*this); src.accept(*this); }
+inline void Const_Visitor::visit_mov(const Instr &dst, const Instr &src) { dst.accept(*this); src.accept(*this); }
+inline void Const_Visitor::visit_jmp(const Instr &target) { target.accept(*this); }
+
+inline void Const_Visitor::visit_while(Instrs_View conditions, std::span<const Bool_Op> bool_ops, Instrs_View body) {
+    this->visit(conditions);
+    this->visit(body);
+}
+
+inline void Const_Visitor::visit_for(const Instr &range_left, const Instr &range_right, const Instr &increment, Instrs_View body) {
+    range_left.accept(*this);
+    range_right.accept(*this);
+    increment.accept(*this);
+    this->visit(body);
+}
+
+inline void Const_Visitor::visit_if(Instrs_View conditions, std::span<const Bool_Op> bool_ops, Instrs_View if_body, Instrs_View else_body) {
+    this->visit(conditions);
+    this->visit(if_body);
+    this->visit(else_body);
+}
+
+inline void Const_Visitor::visit_cond(Cond_Op op, const Instr &lhs, const Instr &rhs) { lhs.accept(*this); rhs.accept(*this); }
+
+// Compilation context owning a syntax tree and the arena it lives in.
+// The tree has to be built inside an Arena::Scope of the arena, then the
+// nodes are never destroyed one by one: the arena is released at once.
+class Ast {
+    public:
+        // Default c'tor.
+        explicit Ast() : instructions(*new (arena.allocate(sizeof(Instrs), alignof(Instrs))) Instrs(&arena)) {}
+        // Deleting copy c'tor.
+        explicit Ast(const Ast &other) = delete;
+
+        // memory of the whole tree.
+        Arena arena;
+        // the program (allocated inside the arena, never destroyed).
+        Instrs &instructions;
 };
 
 #endif // INSTRUCTIONSET_H
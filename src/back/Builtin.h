@@ -0,0 +1,34 @@
+#ifndef BUILTIN_H
+#define BUILTIN_H
+
+#include <string_view>
+
+#include "../InstructionSet.h"
+#include "../shared/Sink.h"
+#include "Template.h"
+#include "X86_64.h"
+
+// Backend linked inside xtasm.
+struct Builtin_Backend {
+    // name used by '-target'.
+    std::string_view name;
+    // Used to translate a program.
+    void (*compile)(const Instrs &instructions, Sink &out);
+};
+
+// Table of the built-in backends, out of tree backends are loaded as plugins (see 'dll.h').
+inline constexpr Builtin_Backend BUILTINS[] = {
+    { "template", compile_template },
+    { "x86_64", compile_x86_64 },
+};
+
+// Used to find a built-in backend by name (nullptr if missing).
+constexpr const Builtin_Backend *find_builtin(std::string_view name) {
+    for (auto &backend : BUILTINS) {
+        if (backend.name == name) return &backend;
+    }
+
+    return nullptr;
+}
+
+#endif // BUILTIN_H
@@ -0,0 +1,258 @@
+#include "Elf.h"
+#include "../middle/Opt.h"
+
+#include <elf.h>
+#include <string>
+
+namespace {
+
+// Address of the executable in memory.
+constexpr uint64_t BASE = 0x400000;
+// Size of a page.
+constexpr uint64_t PAGE = 0x1000;
+
+uint64_t align(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Placement of the variables inside .data and .bss.
+struct Layout {
+    // offset of every variable inside its own section.
+    std::vector<uint64_t> offsets;
+    uint64_t data_size = 0;
+    uint64_t bss_size = 0;
+
+    explicit Layout(const Lir_Program &program) {
+        for (auto &var : program.vars) {
+            auto &size = var.bss ? this->bss_size : this->data_size;
+            this->offsets.push_back(size);
+            size += 8;
+        }
+    }
+};
+
+// Used to write a plain structure.
+template <typename T>
+void raw(Sink &out, const T &value) {
+    out.write(std::string_view((const char *) &value, sizeof(T)));
+}
+
+// Used to write zeros up to offset.
+void pad(Sink &out, uint64_t &written, uint64_t offset) {
+    for (; written < offset; written++) out.put('\0');
+}
+
+// Used to write the initial values of .data.
+void write_data(Sink &out, const Lir_Program &program) {
+    for (auto &var : program.vars) {
+        if (!var.bss) raw(out, var.value);
+    }
+}
+
+// Used to fill an ELF header.
+Elf64_Ehdr header(uint16_t type) {
+    Elf64_Ehdr ehdr = {};
+    ehdr.e_ident[EI_MAG0] = ELFMAG0;
+    ehdr.e_ident[EI_MAG1] = ELFMAG1;
+    ehdr.e_ident[EI_MAG2] = ELFMAG2;
+    ehdr.e_ident[EI_MAG3] = ELFMAG3;
+    ehdr.e_ident[EI_CLASS] = ELFCLASS64;
+    ehdr.e_ident[EI_DATA] = ELFDATA2LSB;
+    ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+    ehdr.e_ident[EI_OSABI] = ELFOSABI_SYSV;
+    ehdr.e_type = type;
+    ehdr.e_machine = EM_X86_64;
+    ehdr.e_version = EV_CURRENT;
+    ehdr.e_ehsize = sizeof(Elf64_Ehdr);
+    return ehdr;
+}
+
+void write_exec(const Lir_Program &program, const X86_Code &code, Sink &out) {
+    Layout layout(program);
+    bool has_vars = layout.data_size || layout.bss_size;
+
+    // [headers][text] in the first (R X) segment, [data] on its own page in the second (R W) one.
+    uint64_t headers = sizeof(Elf64_Ehdr) + (has_vars ? 2 : 1) * sizeof(Elf64_Phdr);
+    uint64_t text_offset = headers;
+    uint64_t data_offset = align(text_offset + code.text.size(), PAGE);
+    uint64_t data_addr = BASE + data_offset;
+    uint64_t bss_addr = data_addr + layout.data_size;
+
+    auto ehdr = header(ET_EXEC);
+    ehdr.e_entry = BASE + text_offset;
+    ehdr.e_phoff = sizeof(Elf64_Ehdr);
+    ehdr.e_phentsize = sizeof(Elf64_Phdr);
+    ehdr.e_phnum = has_vars ? 2 : 1;
+    raw(out, ehdr);
+
+    Elf64_Phdr text = {};
+    text.p_type = PT_LOAD;
+    text.p_flags = PF_R | PF_X;
+    text.p_offset = 0;
+    text.p_vaddr = text.p_paddr = BASE;
+    text.p_filesz = text.p_memsz = text_offset + code.text.size();
+    text.p_align = PAGE;
+    raw(out, text);
+
+    if (has_vars) {
+        Elf64_Phdr data = {};
+        data.p_type = PT_LOAD;
+        data.p_flags = PF_R | PF_W;
+        data.p_offset = data_offset;
+        data.p_vaddr = data.p_paddr = data_addr;
+        data.p_filesz = layout.data_size;
+        data.p_memsz = layout.data_size + layout.bss_size;
+        data.p_align = PAGE;
+        raw(out, data);
+    }
+
+    // every address is known, the variables can be resolved right away.
+    auto text_bytes = code.text;
+    for (auto &ref : code.var_refs) {
+        auto &var = program.vars[ref.var];
+        uint64_t addr = (var.bss ? bss_addr : data_addr) + layout.offsets[ref.var];
+        int32_t rel = addr + ref.addend - (BASE + text_offset + ref.offset);
+        for (int i = 0; i < 4; i++) text_bytes[ref.offset + i] = rel >> (i * 8);
+    }
+
+    out.write(std::string_view((const char *) text_bytes.data(), text_bytes.size()));
+
+    if (has_vars) {
+        uint64_t written = text_offset + text_bytes.size();
+        pad(out, written, data_offset);
+        write_data(out, program);
+    }
+}
+
+void write_object(const Lir_Program &program, const X86_Code &code, Sink &out) {
+    Layout layout(program);
+
+    // indexes of the sections.
+    enum { NONE, TEXT, DATA, BSS, RELA, SYMTAB, STRTAB, SHSTRTAB, COUNT };
+
+    // names of the sections.
+    std::string shstrtab("\0", 1);
+    auto section_name = [&](const char *name) {
+        uint32_t offset = shstrtab.size();
+        shstrtab += name;
+        shstrtab += '\0';
+        return offset;
+    };
+
+    // symbols: null, the sections, the variables (local) and '_start' (global).
+    std::string strtab("\0", 1);
+    std::vector<Elf64_Sym> symbols(4, Elf64_Sym {});
+    for (uint16_t section = TEXT; section <= BSS; section++) {
+        symbols[section].st_info = ELF64_ST_INFO(STB_LOCAL, STT_SECTION);
+        symbols[section].st_shndx = section;
+    }
+
+    for (uint_t i = 0; i < program.vars.size(); i++) {
+        Elf64_Sym sym = {};
+        sym.st_name = strtab.size();
+        sym.st_info = ELF64_ST_INFO(STB_LOCAL, STT_OBJECT);
+        sym.st_shndx = program.vars[i].bss ? BSS : DATA;
+        sym.st_value = layout.offsets[i];
+        sym.st_size = 8;
+        symbols.push_back(sym);
+
+        strtab += "v." + program.vars[i].name;
+        strtab += '\0';
+    }
+
+    uint32_t first_global = symbols.size();
+    Elf64_Sym start = {};
+    start.st_name = strtab.size();
+    start.st_info = ELF64_ST_INFO(STB_GLOBAL, STT_FUNC);
+    start.st_shndx = TEXT;
+    start.st_size = code.text.size();
+    symbols.push_back(start);
+    strtab += "_start";
+    strtab += '\0';
+
+    // the variables are reached through their section symbol.
+    std::vector<Elf64_Rela> relocations;
+    for (auto &ref : code.var_refs) {
+        bool bss = program.vars[ref.var].bss;
+        Elf64_Rela rela = {};
+        rela.r_offset = ref.offset;
+        rela.r_info = ELF64_R_INFO(bss ? BSS : DATA, R_X86_64_PC32);
+        rela.r_addend = (int64_t) layout.offsets[ref.var] + ref.addend;
+        relocations.push_back(rela);
+    }
+
+    // file layout: header, then every section, then the section headers.
+    uint64_t offsets[COUNT] = {}, sizes[COUNT] = {};
+    uint64_t offset = sizeof(Elf64_Ehdr);
+    auto place = [&](int section, uint64_t size, uint64_t alignment) {
+        offset = align(offset, alignment);
+        offsets[section] = offset;
+        sizes[section] = size;
+        offset += size;
+    };
+
+    place(TEXT, code.text.size(), 16);
+    place(DATA, layout.data_size, 8);
+    offsets[BSS] = offset;
+    sizes[BSS] = layout.bss_size;
+    place(RELA, relocations.size() * sizeof(Elf64_Rela), 8);
+    place(SYMTAB, symbols.size() * sizeof(Elf64_Sym), 8);
+    place(STRTAB, strtab.size(), 1);
+
+    Elf64_Shdr shdrs[COUNT] = {};
+    shdrs[TEXT] = { section_name(".text"), SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, 0, 0, 0, 0, 0, 16, 0 };
+    shdrs[DATA] = { section_name(".data"), SHT_PROGBITS, SHF_ALLOC | SHF_WRITE, 0, 0, 0, 0, 0, 8, 0 };
+    shdrs[BSS] = { section_name(".bss"), SHT_NOBITS, SHF_ALLOC | SHF_WRITE, 0, 0, 0, 0, 0, 8, 0 };
+    shdrs[RELA] = { section_name(".rela.text"), SHT_RELA, SHF_INFO_LINK, 0, 0, 0, SYMTAB, TEXT, 8, sizeof(Elf64_Rela) };
+    shdrs[SYMTAB] = { section_name(".symtab"), SHT_SYMTAB, 0, 0, 0, 0, STRTAB, first_global, 8, sizeof(Elf64_Sym) };
+    shdrs[STRTAB] = { section_name(".strtab"), SHT_STRTAB, 0, 0, 0, 0, 0, 0, 1, 0 };
+    shdrs[SHSTRTAB] = { section_name(".shstrtab"), SHT_STRTAB, 0, 0, 0, 0, 0, 0, 1, 0 };
+
+    place(SHSTRTAB, shstrtab.size(), 1);
+    uint64_t shoff = align(offset, 8);
+
+    for (int section = TEXT; section < COUNT; section++) {
+        shdrs[section].sh_offset = offsets[section];
+        shdrs[section].sh_size = sizes[section];
+    }
+
+    auto ehdr = header(ET_REL);
+    ehdr.e_shoff = shoff;
+    ehdr.e_shentsize = sizeof(Elf64_Shdr);
+    ehdr.e_shnum = COUNT;
+    ehdr.e_shstrndx = SHSTRTAB;
+    raw(out, ehdr);
+
+    uint64_t written = sizeof(Elf64_Ehdr);
+    auto section = [&](int index, const void *data) {
+        pad(out, written, offsets[index]);
+        out.write(std::string_view((const char *) data, sizes[index]));
+        written += sizes[index];
+    };
+
+    section(TEXT, code.text.data());
+    pad(out, written, offsets[DATA]);
+    write_data(out, program);
+    written += layout.data_size;
+    section(RELA, relocations.data());
+    section(SYMTAB, symbols.data());
+    section(STRTAB, strtab.data());
+    section(SHSTRTAB, shstrtab.data());
+
+    pad(out, written, shoff);
+    for (auto &shdr : shdrs) raw(out, shdr);
+}
+
+}
+
+void write_elf(const Lir_Program &program, const X86_Code &code, Elf_Kind kind, Sink &out) {
+    if (kind == Elf_Kind::EXEC) write_exec(program, code, out);
+    else write_object(program, code, out);
+}
+
+void compile_elf(const Instrs &instructions, Elf_Kind kind, Sink &out) {
+    auto program = optimize(instructions, true);
+    auto code = encode_x86_64(select_x86_64(program), program.labels.size());
+
+    write_elf(program, code, kind, out);
+}
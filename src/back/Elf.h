@@ -0,0 +1,26 @@
+#ifndef ELF_H
+#define ELF_H
+
+#include "../InstructionSet.h"
+#include "../middle/Lir.h"
+#include "../shared/Sink.h"
+#include "X86_64.h"
+
+// ELF64 files for x86-64 Linux, written without any external tool.
+// Initialized variables go in .data, the ones declared with '?' in .bss.
+
+// Kinds of ELF file.
+enum class Elf_Kind {
+    // static executable, entry point at the start of the code.
+    EXEC,
+    // relocatable object exporting '_start', to be linked with ld.
+    OBJECT,
+};
+
+// Used to write an encoded program as an ELF file.
+void write_elf(const Lir_Program &program, const X86_Code &code, Elf_Kind kind, Sink &out);
+
+// Used to translate a program straight into an ELF file.
+void compile_elf(const Instrs &instructions, Elf_Kind kind, Sink &out);
+
+#endif // ELF_H
@@ -0,0 +1,41 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <vector>
+
+#include "../InstructionSet.h"
+#include "../middle/Lir.h"
+#include "X86_64.h"
+
+// Program encoded into the memory of this process and called like a function.
+// Code and variables share one mapping, [code (R X)][variables (R W)], so the
+// rip-relative references always reach the variables and no page is ever both
+// writable and executable. Exit returns its value instead of ending the process.
+class Jit_Program {
+    public:
+        // Used to encode and map a lowered program.
+        explicit Jit_Program(const Lir_Program &program);
+        // Deleting copy c'tor.
+        explicit Jit_Program(const Jit_Program &other) = delete;
+        // Destructor (unmaps the program).
+        ~Jit_Program();
+
+        // Used to run the program from its initial state, returning the value of Exit.
+        int64_t run();
+        // Used to read a variable, as left by the last run.
+        int64_t var(uint_t index) const { return this->vars[index]; }
+    private:
+        // start of the mapping.
+        uint8_t *memory = nullptr;
+        // length of the mapping.
+        uint_t size = 0;
+        // variables, right after the code pages.
+        int64_t *vars = nullptr;
+        // values of the variables before any run.
+        std::vector<int64_t> initial;
+};
+
+// Used to run a program in-process, returning the value of Exit.
+int64_t run_jit(const Instrs &instructions);
+
+#endif // JIT_H
@@ -0,0 +1,62 @@
+#include "Jit.h"
+#include "../middle/Opt.h"
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+uint_t align(uint_t value, uint_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+void crash_errno(std::string msg) {
+    crash(msg + std::strerror(errno));
+}
+
+}
+
+Jit_Program::Jit_Program(const Lir_Program &program) {
+    auto code = encode_x86_64(select_x86_64(program, X86_Exit::RETURN), program.labels.size());
+
+    for (auto &var : program.vars) this->initial.push_back(var.bss ? 0 : var.value);
+
+    uint_t page = sysconf(_SC_PAGESIZE);
+    uint_t code_size = align(code.text.size(), page);
+    this->size = code_size + align(std::max<uint_t>(this->initial.size() * sizeof(int64_t), 1), page);
+
+    auto memory = mmap(nullptr, this->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) crash_errno("Unable to map memory for the program. ");
+    this->memory = (uint8_t *) memory;
+    this->vars = (int64_t *) (this->memory + code_size);
+
+    // the variables sit at a fixed distance from the code, resolving the references in place.
+    std::memcpy(this->memory, code.text.data(), code.text.size());
+    for (auto &ref : code.var_refs) {
+        auto addr = (uint8_t *) (this->vars + ref.var);
+        int32_t rel = addr + ref.addend - (this->memory + ref.offset);
+        std::memcpy(this->memory + ref.offset, &rel, sizeof(rel));
+    }
+
+    // writing is over, the code can become executable.
+    if (mprotect(this->memory, code_size, PROT_READ | PROT_EXEC)) crash_errno("Unable to make the program executable. ");
+}
+
+Jit_Program::~Jit_Program() {
+    if (this->memory) munmap(this->memory, this->size);
+}
+
+int64_t Jit_Program::run() {
+    std::memcpy(this->vars, this->initial.data(), this->initial.size() * sizeof(int64_t));
+
+    auto entry = (int64_t (*)()) this->memory;
+    return entry();
+}
+
+int64_t run_jit(const Instrs &instructions) {
+    Jit_Program program(optimize(instructions, true));
+    return program.run();
+}
@@ -0,0 +1,10 @@
+#include "Template.h"
+
+void compile_template(const Instrs &instructions, Sink &out) {
+    Template_Visitor v(out);
+
+    for (auto &ptr : instructions) {
+        ptr->accept(v);
+        out << '\n';
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef TEMPLATE_H
+#define TEMPLATE_H
+
+#include "../InstructionSet.h"
+#include "../shared/Sink.h"
+
+// Built-in version of 'libtemplate.cpp', a starting point for new backends.
+// Marked final so the calls between the visit methods are devirtualized.
+class Template_Visitor final : public Const_Visitor {
+    public:
+        explicit Template_Visitor(Sink &out) : out(out) {}
+
+        void visit_data(Instrs_View variables) { this->out << "compile_data"; }
+        void visit_code(Instrs_View instructions) { this->out << "compile_code"; }
+        void visit_label(std::string_view name) { this->out << "compile_label"; }
+        void visit_exit(const Instr &value) { this->out << "compile_exit"; }
+        void visit_add(const Instr &dst, const Instr &src) { this->out << "compile_add"; }
+        void visit_sub(const Instr &dst, const Instr &src) { this->out << "compile_sub"; }
+        void visit_mul(const Instr &dst, const Instr &src) { this->out << "compile_mul"; }
+        void visit_mov(const Instr &dst, const Instr &src) { this->out << "compile_mov"; }
+        void visit_jmp(const Instr &target) { this->out << "compile_jmp"; }
+        void visit_break() { this->out << "compile_break"; }
+        void visit_enum(std::string_view name, Instrs_View values) { this->out << "compile_enum"; }
+        void visit_while(Instrs_View conditions, std::span<const Bool_Op> bool_ops, Instrs_View body) { this->out << "compile_while"; }
+        void visit_for(const Instr &range_left, const Instr &range_right, const Instr &increment, Instrs_View body) { this->out << "compile_for"; }
+        void visit_loop(Instrs_View body) { this->out << "compile_loop"; }
+        void visit_if(Instrs_View conditions, std::span<const Bool_Op> bool_ops, Instrs_View if_body, Instrs_View else_body) { this->out << "compile_if"; }
+        void visit_cond(Cond_Op op, const Instr &lhs, const Instr &rhs) { this->out << "compile_cond"; }
+        void visit_var(std::string_view name, std::string_view value, bool is_decl) { this->out << "compile_var"; }
+        void visit_txt(std::string_view value) { this->out << value; }
+
+    private:
+        // where the code is written.
+        Sink &out;
+};
+
+// Used to translate a program with the template backend.
+void compile_template(const Instrs &instructions, Sink &out);
+
+#endif // TEMPLATE_H
@@ -0,0 +1,322 @@
+#include "X86_64.h"
+#include "../middle/Opt.h"
+
+#include <climits>
+
+namespace {
+
+// Used to know if an immediate fits the 32 bit (sign-extended) field of an instruction.
+bool is_imm32(const Operand &op) {
+    return op.kind == Operand_Kind::IMM && op.value >= INT32_MIN && op.value <= INT32_MAX;
+}
+
+// Used to get the comparison with swapped operands (a < b  <=>  b > a).
+Cond_Op swap(Cond_Op cond) {
+    switch (cond) {
+        case LTH: return GT;
+        case LTE: return GTE;
+        case GT: return LTH;
+        case GTE: return LTE;
+        default: return cond;
+    }
+}
+
+// Picks the machine instructions of the lowered ones.
+class Selector {
+    public:
+        explicit Selector(std::vector<X86_Instr> &out, X86_Exit exit) : out(out), exit(exit) {}
+
+        // Used to save the registers the caller expects to find untouched.
+        void prologue();
+        void instr(const Lir_Instr &instr);
+    private:
+        // Used to append a machine instruction.
+        void emit(X86_Op op, Operand dst = {}, Operand src = {}) { this->out.push_back({ op, EQU, dst, src, 0, 0 }); }
+        // Used to make src usable together with dst, moving it into the scratch register if needed.
+        Operand fix(const Operand &src, const Operand &dst);
+
+        std::vector<X86_Instr> &out;
+        X86_Exit exit;
+};
+
+// Registers a function has to preserve (System V), the program can write them.
+const int64_t CALLEE_SAVED[] = { 3, 12, 13, 14, 15 };
+
+void Selector::prologue() {
+    if (this->exit != X86_Exit::RETURN) return;
+    for (auto reg : CALLEE_SAVED) this->emit(X86_Op::PUSH, reg_op(reg));
+
+    // programs start with every register cleared, like an executable does.
+    for (int64_t reg = 0; reg < (int64_t) REG_COUNT; reg++) {
+        if (reg != 4 && reg != 5 && reg != REG_SCRATCH) this->emit(X86_Op::MOV, reg_op(reg), imm_op(0));
+    }
+}
+
+Operand Selector::fix(const Operand &src, const Operand &dst) {
+    auto scratch = reg_op(REG_SCRATCH);
+
+    // 64 bit immediates only fit movabs.
+    if (src.kind == Operand_Kind::IMM && !is_imm32(src)) {
+        this->out.push_back({ X86_Op::MOVABS, EQU, scratch, {}, src.value, 0 });
+        return scratch;
+    }
+
+    // only one memory operand per instruction.
+    if (src.kind == Operand_Kind::VAR && dst.kind == Operand_Kind::VAR) {
+        this->emit(X86_Op::MOV, scratch, src);
+        return scratch;
+    }
+
+    return src;
+}
+
+void Selector::instr(const Lir_Instr &instr) {
+    auto scratch = reg_op(REG_SCRATCH);
+
+    switch (instr.op) {
+        case Lir_Op::LABEL:
+            this->out.push_back({ X86_Op::LABEL, EQU, {}, {}, 0, (uint32_t) instr.a.value });
+            break;
+
+        case Lir_Op::MOV:
+            if (instr.a.kind == Operand_Kind::REG && instr.b.kind == Operand_Kind::IMM && !is_imm32(instr.b)) {
+                this->out.push_back({ X86_Op::MOVABS, EQU, instr.a, {}, instr.b.value, 0 });
+            } else {
+                this->emit(X86_Op::MOV, instr.a, this->fix(instr.b, instr.a));
+            }
+            break;
+
+        case Lir_Op::ADD:
+            this->emit(X86_Op::ADD, instr.a, this->fix(instr.b, instr.a));
+            break;
+
+        case Lir_Op::SUB:
+            this->emit(X86_Op::SUB, instr.a, this->fix(instr.b, instr.a));
+            break;
+
+        case Lir_Op::MUL:
+            // imul can only write a register.
+            if (instr.a.kind == Operand_Kind::REG) {
+                if (is_imm32(instr.b)) {
+                    this->out.push_back({ X86_Op::IMUL3, EQU, instr.a, instr.a, instr.b.value, 0 });
+                } else {
+                    this->emit(X86_Op::IMUL, instr.a, this->fix(instr.b, instr.a));
+                }
+            } else if (is_imm32(instr.b)) {
+                this->out.push_back({ X86_Op::IMUL3, EQU, scratch, instr.a, instr.b.value, 0 });
+                this->emit(X86_Op::MOV, instr.a, scratch);
+            } else if (instr.b.kind == Operand_Kind::IMM) {
+                // the product commutes, the scratch can hold the immediate.
+                this->out.push_back({ X86_Op::MOVABS, EQU, scratch, {}, instr.b.value, 0 });
+                this->emit(X86_Op::IMUL, scratch, instr.a);
+                this->emit(X86_Op::MOV, instr.a, scratch);
+            } else {
+                this->emit(X86_Op::MOV, scratch, instr.a);
+                this->emit(X86_Op::IMUL, scratch, instr.b);
+                this->emit(X86_Op::MOV, instr.a, scratch);
+            }
+            break;
+
+        case Lir_Op::SHL:
+            this->emit(X86_Op::SHL, instr.a, instr.b);
+            break;
+
+        case Lir_Op::JMP:
+            this->out.push_back({ X86_Op::JMP, EQU, {}, {}, 0, (uint32_t) instr.a.value });
+            break;
+
+        case Lir_Op::BR: {
+            auto a = instr.a, b = instr.b;
+            auto cond = instr.cond;
+
+            // comparing two known values.
+            if (a.kind == Operand_Kind::IMM && b.kind == Operand_Kind::IMM) {
+                if (compare(cond, a.value, b.value)) this->out.push_back({ X86_Op::JMP, EQU, {}, {}, 0, instr.target });
+                break;
+            }
+
+            // cmp can't take an immediate on the left.
+            if (a.kind == Operand_Kind::IMM) {
+                std::swap(a, b);
+                cond = swap(cond);
+            }
+
+            this->emit(X86_Op::CMP, a, this->fix(b, a));
+            this->out.push_back({ X86_Op::JCC, cond, {}, {}, 0, instr.target });
+        } break;
+
+        case Lir_Op::EXIT: {
+            // exit(rdi) or return rax.
+            auto value = reg_op(this->exit == X86_Exit::SYSCALL ? 7 : 0);
+
+            if (instr.a.kind == Operand_Kind::IMM && !is_imm32(instr.a)) {
+                this->out.push_back({ X86_Op::MOVABS, EQU, value, {}, instr.a.value, 0 });
+            } else {
+                this->emit(X86_Op::MOV, value, instr.a);
+            }
+
+            if (this->exit == X86_Exit::SYSCALL) {
+                this->emit(X86_Op::MOV, reg_op(0), imm_op(60));
+                this->emit(X86_Op::SYSCALL);
+                break;
+            }
+
+            for (int i = std::size(CALLEE_SAVED) - 1; i >= 0; i--) this->emit(X86_Op::POP, reg_op(CALLEE_SAVED[i]));
+            this->emit(X86_Op::RET);
+        } break;
+    }
+}
+
+// Mnemonics of the machine instructions.
+const char *MNEMONICS[] = {
+    "", "movq", "movabsq", "addq", "subq", "imulq", "imulq", "cmpq", "jmp", "", "syscall", "pushq", "popq", "ret", "shlq",
+};
+
+// Conditional jumps (signed comparisons).
+const char *JCC[] = {
+    // EQU, NEQU, LTH, LTE, GT, GTE.
+    "je", "jne", "jl", "jle", "jg", "jge",
+};
+
+// Writes the machine instructions as GNU assembly.
+class Writer {
+    public:
+        explicit Writer(const Lir_Program &program, Sink &out) : program(program), out(out) {}
+
+        // Used to write the whole program.
+        void write();
+    private:
+        // Used to write an operand.
+        void operand(const Operand &op);
+        // Used to write a label name.
+        void label(uint32_t label);
+
+        void instr(const X86_Instr &instr);
+
+        const Lir_Program &program;
+        Sink &out;
+};
+
+void Writer::operand(const Operand &op) {
+    switch (op.kind) {
+        case Operand_Kind::REG:
+            this->out << "%" << REG_NAMES[op.value];
+            break;
+
+        case Operand_Kind::VAR:
+            this->out << "v." << this->program.vars[op.value].name << "(%rip)";
+            break;
+
+        case Operand_Kind::IMM:
+            this->out << '$';
+            this->out.write_int(op.value);
+            break;
+
+        case Operand_Kind::LBL:
+            this->label(op.value);
+            break;
+
+        case Operand_Kind::NONE:
+            crash("Missing operand inside the lowered program.\n");
+    }
+}
+
+void Writer::label(uint32_t label) {
+    // user labels can look like crafted ones (':while.0.test'), each kind has its own prefix.
+    auto &lbl = this->program.labels[label];
+    this->out << (lbl.user ? ".L.u." : ".L.") << lbl.name;
+}
+
+void Writer::instr(const X86_Instr &instr) {
+    switch (instr.op) {
+        case X86_Op::LABEL:
+            this->label(instr.label);
+            this->out << ":\n";
+            return;
+
+        case X86_Op::JMP:
+        case X86_Op::JCC:
+            this->out << '\t' << (instr.op == X86_Op::JMP ? "jmp" : JCC[instr.cond]) << ' ';
+            this->label(instr.label);
+            this->out << '\n';
+            return;
+
+        case X86_Op::SYSCALL:
+        case X86_Op::RET:
+            this->out << '\t' << MNEMONICS[(int) instr.op] << '\n';
+            return;
+
+        case X86_Op::PUSH:
+        case X86_Op::POP:
+            this->out << '\t' << MNEMONICS[(int) instr.op] << ' ';
+            this->operand(instr.dst);
+            this->out << '\n';
+            return;
+
+        case X86_Op::MOVABS:
+            this->out << "\tmovabsq $";
+            this->out.write_int(instr.imm);
+            break;
+
+        case X86_Op::IMUL3:
+            this->out << "\timulq $";
+            this->out.write_int(instr.imm);
+            this->out << ", ";
+            this->operand(instr.src);
+            break;
+
+        default:
+            this->out << '\t' << MNEMONICS[(int) instr.op] << ' ';
+            this->operand(instr.src);
+            break;
+    }
+
+    this->out << ", ";
+    this->operand(instr.dst);
+    this->out << '\n';
+}
+
+void Writer::write() {
+    // initialized variables.
+    this->out << "\t.data\n\t.balign 8\n";
+    for (auto &var : this->program.vars) {
+        if (var.bss) continue;
+
+        this->out << "v." << var.name << ":\n\t.quad ";
+        this->out.write_int(var.value);
+        this->out << '\n';
+    }
+
+    // variables without a value.
+    this->out << "\n\t.bss\n\t.balign 8\n";
+    for (auto &var : this->program.vars) {
+        if (!var.bss) continue;
+
+        this->out << "v." << var.name << ":\n\t.zero 8\n";
+    }
+
+    this->out << "\n\t.text\n\t.globl _start\n_start:\n";
+    for (auto &instr : select_x86_64(this->program)) this->instr(instr);
+}
+
+}
+
+std::vector<X86_Instr> select_x86_64(const Lir_Program &program, X86_Exit exit) {
+    std::vector<X86_Instr> instrs;
+    instrs.reserve(program.code.size() * 2);
+
+    Selector selector(instrs, exit);
+    selector.prologue();
+    for (auto &instr : program.code) selector.instr(instr);
+
+    return instrs;
+}
+
+void emit_x86_64(const Lir_Program &program, Sink &out) {
+    Writer writer(program, out);
+    writer.write();
+}
+
+void compile_x86_64(const Instrs &instructions, Sink &out) {
+    emit_x86_64(optimize(instructions, true), out);
+}
@@ -0,0 +1,98 @@
+#ifndef X86_64_H
+#define X86_64_H
+
+#include <cstdint>
+#include <vector>
+
+#include "../InstructionSet.h"
+#include "../middle/Lir.h"
+#include "../shared/Sink.h"
+
+// Native backend for x86-64 Linux.
+// The lowered instructions are first turned into machine instructions,
+// which are then written as GNU assembly (AT&T syntax), built with:
+//     as out.s -o out.o && ld out.o -o out
+// or encoded straight into an ELF file (see 'Elf.h').
+// Variables live in .data/.bss, '$' registers are the machine registers
+// and r11 is kept as scratch register.
+
+// Machine instructions used by the backend (every operation is 64 bit).
+enum class X86_Op : uint8_t {
+    // label.
+    LABEL,
+    // dst = src.
+    MOV,
+    // dst = imm (64 bit immediate, dst is a register).
+    MOVABS,
+    // dst += src.
+    ADD,
+    // dst -= src.
+    SUB,
+    // dst *= src (dst is a register).
+    IMUL,
+    // dst = src * imm (dst is a register, imm fits 32 bit).
+    IMUL3,
+    // flags of dst - src.
+    CMP,
+    // goto label.
+    JMP,
+    // if (cond) goto label.
+    JCC,
+    // system call (the number is in rax).
+    SYSCALL,
+    // push dst (a register).
+    PUSH,
+    // pop dst (a register).
+    POP,
+    // return to the caller.
+    RET,
+    // dst <<= src (an immediate below 64).
+    SHL,
+};
+
+// How EXIT leaves the program.
+enum class X86_Exit {
+    // exit system call, for executables.
+    SYSCALL,
+    // return the value in rax to the caller, for code called in-process (see 'Jit.h').
+    RETURN,
+};
+
+struct X86_Instr {
+    X86_Op op;
+    // condition of a JCC.
+    Cond_Op cond = EQU;
+    Operand dst;
+    Operand src;
+    int64_t imm = 0;
+    // label of LABEL, JMP and JCC.
+    uint32_t label = 0;
+};
+
+// Used to pick the machine instructions of a lowered program.
+std::vector<X86_Instr> select_x86_64(const Lir_Program &program, X86_Exit exit = X86_Exit::SYSCALL);
+
+// Reference to a variable inside the machine code.
+// The 32 bit field at offset has to become: address(var) + addend - address(field).
+struct X86_Var_Ref {
+    uint32_t offset;
+    uint32_t var;
+    int32_t addend;
+};
+
+// Encoded program, only the variables are left to resolve.
+struct X86_Code {
+    std::vector<uint8_t> text;
+    std::vector<X86_Var_Ref> var_refs;
+};
+
+// Used to encode the machine instructions, jumps to labels are resolved.
+X86_Code encode_x86_64(const std::vector<X86_Instr> &instrs, uint_t label_count);
+
+// Used to write a lowered program as assembly.
+void emit_x86_64(const Lir_Program &program, Sink &out);
+
+// Used to translate a program with the x86-64 backend.
+void compile_x86_64(const Instrs &instructions, Sink &out);
+
+#endif // X86_64_H
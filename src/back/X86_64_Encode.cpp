@@ -0,0 +1,203 @@
+#include "X86_64.h"
+
+namespace {
+
+// Opcode extensions (the /digit of the reference) of the immediate forms.
+enum Ext {
+    EXT_ADD = 0,
+    EXT_SHL = 4,
+    EXT_SUB = 5,
+    EXT_CMP = 7,
+};
+
+// Condition codes of the conditional jumps (0F 80+cc).
+const uint8_t CC[] = {
+    // EQU, NEQU, LTH, LTE, GT, GTE.
+    0x4, 0x5, 0xC, 0xE, 0xF, 0xD,
+};
+
+bool is_imm8(int64_t value) { return value >= INT8_MIN && value <= INT8_MAX; }
+
+class Encoder {
+    public:
+        explicit Encoder(X86_Code &code, uint_t label_count) : code(code), labels(label_count, 0) {}
+
+        void instr(const X86_Instr &instr);
+        // Used to resolve the jumps once every label is known.
+        void resolve();
+    private:
+        void byte(uint8_t b) { this->code.text.push_back(b); }
+        void dword(int32_t value) {
+            for (int i = 0; i < 4; i++) this->byte(value >> (i * 8));
+        }
+        void qword(int64_t value) {
+            for (int i = 0; i < 8; i++) this->byte(value >> (i * 8));
+        }
+
+        // Used to encode REX.W + opcode + ModRM (+ displacement), reg is a register
+        // number or an opcode extension, trailing is the size of the immediate that follows.
+        void modrm(std::initializer_list<uint8_t> opcode, int64_t reg, const Operand &rm, int trailing = 0);
+        // Used to encode an instruction of the add/sub/cmp family.
+        void arith(uint8_t op_rm_reg, uint8_t op_reg_rm, Ext ext, const X86_Instr &instr);
+        // Used to encode a 32 bit jump displacement to a label.
+        void rel32(uint32_t label);
+
+        X86_Code &code;
+        // offset of every label.
+        std::vector<uint32_t> labels;
+        // jumps to resolve: offset of the displacement, label.
+        std::vector<std::pair<uint32_t, uint32_t>> jumps;
+};
+
+void Encoder::modrm(std::initializer_list<uint8_t> opcode, int64_t reg, const Operand &rm, int trailing) {
+    bool rm_ext = rm.kind == Operand_Kind::REG && (rm.value & 8);
+    this->byte(0x48 | ((reg & 8) ? 0x4 : 0) | (rm_ext ? 0x1 : 0));
+    for (auto b : opcode) this->byte(b);
+
+    if (rm.kind == Operand_Kind::REG) {
+        this->byte(0xC0 | (reg & 7) << 3 | (rm.value & 7));
+        return;
+    }
+
+    if (rm.kind != Operand_Kind::VAR) crash("Invalid machine instruction operand.\n");
+
+    // variables are addressed relative to the next instruction.
+    this->byte(0x05 | (reg & 7) << 3);
+    this->code.var_refs.push_back({ (uint32_t) this->code.text.size(), (uint32_t) rm.value, -4 - trailing });
+    this->dword(0);
+}
+
+void Encoder::arith(uint8_t op_rm_reg, uint8_t op_reg_rm, Ext ext, const X86_Instr &instr) {
+    switch (instr.src.kind) {
+        case Operand_Kind::IMM:
+            if (is_imm8(instr.src.value)) {
+                this->modrm({ 0x83 }, ext, instr.dst, 1);
+                this->byte(instr.src.value);
+            } else {
+                this->modrm({ 0x81 }, ext, instr.dst, 4);
+                this->dword(instr.src.value);
+            }
+            break;
+
+        case Operand_Kind::REG:
+            this->modrm({ op_rm_reg }, instr.src.value, instr.dst);
+            break;
+
+        default:
+            this->modrm({ op_reg_rm }, instr.dst.value, instr.src);
+            break;
+    }
+}
+
+void Encoder::rel32(uint32_t label) {
+    this->jumps.push_back({ (uint32_t) this->code.text.size(), label });
+    this->dword(0);
+}
+
+void Encoder::instr(const X86_Instr &instr) {
+    switch (instr.op) {
+        case X86_Op::LABEL:
+            this->labels[instr.label] = this->code.text.size();
+            break;
+
+        case X86_Op::MOV:
+            if (instr.src.kind == Operand_Kind::IMM) {
+                this->modrm({ 0xC7 }, 0, instr.dst, 4);
+                this->dword(instr.src.value);
+            } else if (instr.src.kind == Operand_Kind::REG) {
+                this->modrm({ 0x89 }, instr.src.value, instr.dst);
+            } else {
+                this->modrm({ 0x8B }, instr.dst.value, instr.src);
+            }
+            break;
+
+        case X86_Op::MOVABS:
+            this->byte(0x48 | ((instr.dst.value & 8) ? 0x1 : 0));
+            this->byte(0xB8 + (instr.dst.value & 7));
+            this->qword(instr.imm);
+            break;
+
+        case X86_Op::ADD:
+            this->arith(0x01, 0x03, EXT_ADD, instr);
+            break;
+
+        case X86_Op::SUB:
+            this->arith(0x29, 0x2B, EXT_SUB, instr);
+            break;
+
+        case X86_Op::CMP:
+            this->arith(0x39, 0x3B, EXT_CMP, instr);
+            break;
+
+        case X86_Op::IMUL:
+            this->modrm({ 0x0F, 0xAF }, instr.dst.value, instr.src);
+            break;
+
+        case X86_Op::IMUL3:
+            if (is_imm8(instr.imm)) {
+                this->modrm({ 0x6B }, instr.dst.value, instr.src, 1);
+                this->byte(instr.imm);
+            } else {
+                this->modrm({ 0x69 }, instr.dst.value, instr.src, 4);
+                this->dword(instr.imm);
+            }
+            break;
+
+        case X86_Op::JMP:
+            this->byte(0xE9);
+            this->rel32(instr.label);
+            break;
+
+        case X86_Op::JCC:
+            this->byte(0x0F);
+            this->byte(0x80 | CC[instr.cond]);
+            this->rel32(instr.label);
+            break;
+
+        case X86_Op::SYSCALL:
+            this->byte(0x0F);
+            this->byte(0x05);
+            break;
+
+        case X86_Op::PUSH:
+        case X86_Op::POP:
+            if (instr.dst.value & 8) this->byte(0x41);
+            this->byte((instr.op == X86_Op::PUSH ? 0x50 : 0x58) + (instr.dst.value & 7));
+            break;
+
+        case X86_Op::RET:
+            this->byte(0xC3);
+            break;
+
+        case X86_Op::SHL:
+            // shifting by one has a form of its own.
+            if (instr.src.value == 1) {
+                this->modrm({ 0xD1 }, EXT_SHL, instr.dst);
+            } else {
+                this->modrm({ 0xC1 }, EXT_SHL, instr.dst, 1);
+                this->byte(instr.src.value);
+            }
+            break;
+    }
+}
+
+void Encoder::resolve() {
+    for (auto [offset, label] : this->jumps) {
+        int32_t rel = (int64_t) this->labels[label] - (offset + 4);
+        for (int i = 0; i < 4; i++) this->code.text[offset + i] = rel >> (i * 8);
+    }
+}
+
+}
+
+X86_Code encode_x86_64(const std::vector<X86_Instr> &instrs, uint_t label_count) {
+    X86_Code code;
+    // most instructions take less than 8 bytes.
+    code.text.reserve(instrs.size() * 8);
+
+    Encoder encoder(code, label_count);
+    for (auto &instr : instrs) encoder.instr(instr);
+    encoder.resolve();
+
+    return code;
+}
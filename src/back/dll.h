@@ -1,12 +1,79 @@
 #ifndef DLL_H
 #define DLL_H
 
-#include <vector>
+#include <span>
 #include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../FlatAst.h"
+#include "../middle/Lir.h"
+#include "../shared/Sink.h"
+#include "xt_backend.h"
+
+// Implementing the table of the loaded backend plugins as a singleton.
+// Every plugin is opened once (and kept open until the end), later
+// compilations reuse the handle and the state of the backend.
+class Backend_Registry {
+    public:
+        // Deleting copy c'tor.
+        explicit Backend_Registry(const Backend_Registry &other) = delete;
+        // Destructor.
+        ~Backend_Registry();
+
+        // Used to get a Backend_Registry reference.
+        static Backend_Registry &get_registry() {
+            static Backend_Registry registry;
+            return registry;
+        }
+
+        // Used to load a plugin ahead of time.
+        void preload(std::string filepath) { this->load(filepath); }
+
+        // Used to know if a plugin takes the lowered program (see compile_lir).
+        bool lowered(std::string filepath) { return this->lir_entry(this->load(filepath)); }
+
+        // Used to translate a program into target code written into out.
+        void compile(std::string filepath, const Flat_Ast &program, Sink &out);
+        // Used to translate a lowered program, for the plugins asking for it.
+        void compile(std::string filepath, const Lir_Program &program, Sink &out);
+        // Used to translate many programs with the same backend.
+        void compile_batch(std::string filepath, std::span<const Flat_Ast *const> programs, std::span<Sink *const> outs);
+    private:
+        // Default c'tor.
+        Backend_Registry() = default;
+
+        // Loaded plugin.
+        struct Plugin {
+            // handle of the dynamic library.
+            void *handle;
+            // table exported by the plugin.
+            const xt_backend *backend;
+            // state returned by backend->create.
+            void *state;
+        };
+
+        // Used to get a plugin, opening it the first time.
+        Plugin &load(std::string &filepath);
+        // Used to run a loaded plugin on a program.
+        void run(Plugin &plugin, std::string &filepath, const Flat_Ast &program, Sink &out);
+        // Used to get the compile_lir of a plugin (nullptr before version 2).
+        static decltype(xt_backend::compile_lir) lir_entry(const Plugin &plugin);
+
+        // plugins by path.
+        std::unordered_map<std::string, Plugin> plugins;
+        // pool of the strings handed to the plugin (reused between calls).
+        std::vector<xt_str> strings;
+        // variables and labels of the lowered program handed to the plugin.
+        std::vector<xt_lir_var> vars;
+        std::vector<xt_lir_label> labels;
+};
 
-#include "../InstructionSet.h"
+// Compile function used to translate the syntax tree into target code.
+// The tree is left untouched, the code is written into out.
+void compile(std::string filepath, const Flat_Ast &program, Sink &out);
 
-// Compile functions used to translate the syntax tree into target code.
-std::string compile(std::string handle, std::vector<std::unique_ptr<Instr>> &instructions);
+// Compile function used to hand a lowered program to a plugin taking it.
+void compile(std::string filepath, const Lir_Program &program, Sink &out);
 
 #endif // DLL_H
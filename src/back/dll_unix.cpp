@@ -1,33 +1,152 @@
 #include "dll.h"
 
 #include <dlfcn.h>
-#include <memory>
 
-std::string compile(std::string handle, std::vector<std::unique_ptr<Instr>> &instructions) {
-    // creating an handle for the dynamic library.
-    void *dll_handle = dlopen(handle.c_str(), RTLD_LAZY);
-    
+// the plugins read the nodes straight from the flat syntax tree.
+static_assert(sizeof(xt_node) == sizeof(Flat_Node) && alignof(xt_node) == alignof(Flat_Node));
+static_assert(offsetof(xt_node, first) == offsetof(Flat_Node, first));
+static_assert(offsetof(xt_node, count) == offsetof(Flat_Node, count));
+static_assert(offsetof(xt_node, value) == offsetof(Flat_Node, value));
+static_assert(offsetof(xt_node, extra) == offsetof(Flat_Node, extra));
+static_assert(XT_TXT == (int) Instr_Kind::TXT && XT_COND == (int) Instr_Kind::COND && XT_DATA == (int) Instr_Kind::DATA);
+
+// the lowered code is handed over as it is, only the variables and the labels are copied.
+static_assert(sizeof(xt_operand) == sizeof(Operand) && offsetof(xt_operand, value) == offsetof(Operand, value));
+static_assert(sizeof(xt_lir_instr) == sizeof(Lir_Instr) && sizeof(Cond_Op) == sizeof(int32_t));
+static_assert(offsetof(xt_lir_instr, cond) == offsetof(Lir_Instr, cond));
+static_assert(offsetof(xt_lir_instr, a) == offsetof(Lir_Instr, a));
+static_assert(offsetof(xt_lir_instr, b) == offsetof(Lir_Instr, b));
+static_assert(offsetof(xt_lir_instr, target) == offsetof(Lir_Instr, target));
+static_assert(XT_LIR_EXIT == (int) Lir_Op::EXIT && XT_LIR_SHL == (int) Lir_Op::SHL && XT_OPERAND_LBL == (int) Operand_Kind::LBL);
+
+// Used to let a plugin write into a Sink.
+static void sink_write(void *ctx, const char *data, size_t len) {
+    ((Sink *) ctx)->write(std::string_view(data, len));
+}
+
+Backend_Registry::~Backend_Registry() {
+    for (auto &[filepath, plugin] : this->plugins) {
+        if (plugin.backend->destroy) plugin.backend->destroy(plugin.state);
+        dlclose(plugin.handle);
+    }
+}
+
+Backend_Registry::Plugin &Backend_Registry::load(std::string &filepath) {
+    auto it = this->plugins.find(filepath);
+    if (it != this->plugins.end()) return it->second;
+
+    // resolving every symbol now, a broken plugin fails here and not in the middle of a compilation.
+    void *handle = dlopen(filepath.c_str(), RTLD_NOW | RTLD_LOCAL);
+
     // crashing in case of error.
-    if (!dll_handle) {
-        auto msg = "Unable to open dynamic library '" + handle + "': ";
+    if (!handle) {
+        auto msg = "Unable to open dynamic library '" + filepath + "': ";
         msg += dlerror();
         msg += "\n";
         crash(msg);
     }
 
-    // creating a link with the library entry point function.
-    const char *(*dll_compile)(std::vector<std::unique_ptr<Instr>> &);
-
-    // searching for the function.
-    dll_compile = (const char *(*)(std::vector<std::unique_ptr<Instr>> &)) dlsym(dll_handle, "compile");
+    // searching for the entry point.
+    auto entry = (xt_backend_entry_fn) dlsym(handle, "xt_backend_entry");
 
     // crashing in case of error.
-    if (!dll_compile) {
-        auto msg = "Unable to find symbol 'compile' inside ':" + handle + "': ";
+    if (!entry) {
+        auto msg = "Unable to find symbol 'xt_backend_entry' inside '" + filepath + "': ";
         msg += dlerror();
         msg += "\n";
         crash(msg);
     }
 
-    return std::string(dll_compile(instructions));
+    auto backend = entry();
+
+    bool compatible = backend && backend->abi_version >= XT_ABI_MIN_VERSION && backend->abi_version <= XT_ABI_VERSION;
+    if (!compatible) {
+        auto msg = "Incompatible backend '" + filepath + "' (expected ABI version " + std::to_string(XT_ABI_MIN_VERSION);
+        msg += " to " + std::to_string(XT_ABI_VERSION) + ")\n";
+        crash(msg);
+    }
+
+    Plugin plugin = { handle, backend, nullptr };
+    if (!backend->compile && !lir_entry(plugin)) {
+        auto msg = "Backend '" + filepath + "' has nothing to compile with.\n";
+        crash(msg);
+    }
+
+    plugin.state = backend->create ? backend->create() : nullptr;
+    return this->plugins.emplace(filepath, plugin).first->second;
+}
+
+void Backend_Registry::run(Plugin &plugin, std::string &filepath, const Flat_Ast &program, Sink &out) {
+    if (!plugin.backend->compile) crash("Backend '" + filepath + "' only takes the lowered program.\n");
+
+    // crafting the view of the pool.
+    this->strings.clear();
+    for (uint32_t i = 0; i < program.pool_size(); i++) {
+        auto str = program.str(i);
+        this->strings.push_back({ str.data(), (uint32_t) str.length() });
+    }
+
+    xt_program view = {
+        .nodes = (const xt_node *) program.nodes.data(),
+        .node_count = (uint32_t) program.nodes.size(),
+        .top = program.top,
+        .strings = this->strings.data(),
+        .string_count = (uint32_t) this->strings.size(),
+    };
+    xt_sink sink = { &out, sink_write };
+
+    if (plugin.backend->compile(plugin.state, &view, &sink)) {
+        auto msg = "Backend '" + filepath + "' failed to compile the program.\n";
+        crash(msg);
+    }
+}
+
+decltype(xt_backend::compile_lir) Backend_Registry::lir_entry(const Plugin &plugin) {
+    // the older tables end before the field.
+    return plugin.backend->abi_version >= 2 ? plugin.backend->compile_lir : nullptr;
+}
+
+void Backend_Registry::compile(std::string filepath, const Flat_Ast &program, Sink &out) {
+    this->run(this->load(filepath), filepath, program, out);
+}
+
+void Backend_Registry::compile(std::string filepath, const Lir_Program &program, Sink &out) {
+    auto &plugin = this->load(filepath);
+    auto entry = lir_entry(plugin);
+    if (!entry) crash("Backend '" + filepath + "' doesn't take the lowered program.\n");
+
+    this->vars.clear();
+    for (auto &var : program.vars) this->vars.push_back({ { var.name.data(), (uint32_t) var.name.length() }, var.value, var.bss });
+    this->labels.clear();
+    for (auto &label : program.labels) this->labels.push_back({ { label.name.data(), (uint32_t) label.name.length() }, label.user });
+
+    xt_lir_program view = {
+        .code = (const xt_lir_instr *) program.code.data(),
+        .code_count = (uint32_t) program.code.size(),
+        .vars = this->vars.data(),
+        .var_count = (uint32_t) this->vars.size(),
+        .labels = this->labels.data(),
+        .label_count = (uint32_t) this->labels.size(),
+    };
+    xt_sink sink = { &out, sink_write };
+
+    if (entry(plugin.state, &view, &sink)) {
+        auto msg = "Backend '" + filepath + "' failed to compile the program.\n";
+        crash(msg);
+    }
+}
+
+void Backend_Registry::compile_batch(std::string filepath, std::span<const Flat_Ast *const> programs, std::span<Sink *const> outs) {
+    if (programs.size() != outs.size()) crash("Every program needs its own output.\n");
+
+    auto &plugin = this->load(filepath);
+    for (uint_t i = 0; i < programs.size(); i++) this->run(plugin, filepath, *programs[i], *outs[i]);
+}
+
+void compile(std::string filepath, const Flat_Ast &program, Sink &out) {
+    Backend_Registry::get_registry().compile(filepath, program, out);
+}
+
+void compile(std::string filepath, const Lir_Program &program, Sink &out) {
+    Backend_Registry::get_registry().compile(filepath, program, out);
 }
@@ -1,84 +1,61 @@
-#include "../InstructionSet.h"
+// Template of a backend plugin.
+// Only 'xt_backend.h' is needed: the plugin doesn't link against xtasm.
 
-class Concrete_Visitor_Name : public Visitor {
-    public: 
-        virtual std::string compile_data(std::vector<std::unique_ptr<Instr>> variables) { 
-            return "compile_data"; 
-        } 
-        
-        virtual std::string compile_code(std::vector<std::unique_ptr<Instr>> instructions) { 
-            return "compile_code"; 
-        }
+#include <cstring>
 
-        virtual std::string compile_label(std::string name) { 
-            return "compile_label"; 
-        }
+#include "xt_backend.h"
 
-        virtual std::string compile_exit(std::string value) { 
-            return "compile_exit"; 
-        }
-
-        virtual std::string compile_add(std::string dst, std::string src) { 
-            return "compile_add"; 
-        }
-
-        virtual std::string compile_sub(std::string dst, std::string src) { 
-            return "compile_sub"; 
-        }
-
-        virtual std::string compile_mul(std::string dst, std::string src) { 
-            return "compile_mul"; 
-        }
-
-        virtual std::string compile_mov(std::string dst, std::string src) { 
-            return "compile_mov"; 
-        }
-
-        virtual std::string compile_jmp(std::string target) { 
-            return "compile_jmp"; 
-        }
-
-        virtual std::string compile_break() { 
-            return "compile_break"; 
-        }
-
-        virtual std::string compile_enum(std::vector<std::unique_ptr<Instr>> values) { 
-            return "compile_enum"; 
-        }
-
-        virtual std::string compile_while(std::vector<std::unique_ptr<Instr>> conditions, 
-                                          std::vector<Bool_Op> bool_ops, 
-                                          std::vector<std::unique_ptr<Instr>> body) { 
-            return "compile_while"; 
-        }
-
-        virtual std::string compile_for(std::unique_ptr<Instr> range_left, 
-                                        std::unique_ptr<Instr> range_right,
-                                        std::unique_ptr<Instr> increment,
-                                        std::vector<std::unique_ptr<Instr>> body) { 
-            return "compile_for"; 
-        }
-
-        virtual std::string compile_loop(std::vector<std::unique_ptr<Instr>> body) { 
-            return "compile_loop"; 
-        }
-
-        virtual std::string compile_var(std::string name, std::string value, bool is_decl) { 
-            return "compile_var"; 
-        }
-};
-
-extern "C" {
+// Used to write a '\0' terminated string.
+static void emit(xt_sink *out, const char *str) {
+    out->write(out->ctx, str, std::strlen(str));
+}
 
-const char *compile(std::vector<std::unique_ptr<Instr>> &instructions) {
-    std::string *buf = new std::string();
-    Concrete_Visitor_Name v;
+// Used to translate a single node.
+static void compile_node(const xt_program *program, const xt_node *node, xt_sink *out) {
+    switch (node->kind) {
+        case XT_DATA: emit(out, "compile_data"); break;
+        case XT_CODE: emit(out, "compile_code"); break;
+        case XT_LABEL: emit(out, "compile_label"); break;
+        case XT_EXIT: emit(out, "compile_exit"); break;
+        case XT_ADD: emit(out, "compile_add"); break;
+        case XT_SUB: emit(out, "compile_sub"); break;
+        case XT_MUL: emit(out, "compile_mul"); break;
+        case XT_MOV: emit(out, "compile_mov"); break;
+        case XT_JMP: emit(out, "compile_jmp"); break;
+        case XT_BREAK: emit(out, "compile_break"); break;
+        case XT_ENUM: emit(out, "compile_enum"); break;
+        case XT_WHILE: emit(out, "compile_while"); break;
+        case XT_FOR: emit(out, "compile_for"); break;
+        case XT_LOOP: emit(out, "compile_loop"); break;
+        case XT_IF: emit(out, "compile_if"); break;
+        case XT_COND: emit(out, "compile_cond"); break;
+        case XT_VAR: emit(out, "compile_var"); break;
+
+        case XT_TXT: {
+            auto str = program->strings[node->value];
+            out->write(out->ctx, str.data, str.len);
+        } break;
+    }
+}
 
-    for (auto &ptr : instructions) {
-        *buf += ptr->compile(v) + "\n";
+static int compile(void *, const xt_program *program, xt_sink *out) {
+    for (uint32_t i = 0; i < program->top; i++) {
+        compile_node(program, &program->nodes[i], out);
+        emit(out, "\n");
     }
 
-    return buf->c_str();
+    return 0;
 }
 
+static const xt_backend BACKEND = {
+    .abi_version = XT_ABI_VERSION,
+    .name = "template",
+    .create = nullptr,
+    .destroy = nullptr,
+    .compile = compile,
+    .compile_lir = nullptr,
+};
+
+extern "C" const xt_backend *xt_backend_entry(void) {
+    return &BACKEND;
 }
@@ -0,0 +1,186 @@
+#ifndef XT_BACKEND_H
+#define XT_BACKEND_H
+
+/*
+ * C interface between xtasm and the backend plugins.
+ * Only C types cross the boundary, so a plugin can be built with any
+ * compiler (or language) able to export a C function.
+ *
+ * A plugin exports:
+ *     const xt_backend *xt_backend_entry(void);
+ *
+ * The program is handed over in its flat form (see 'FlatAst.h'): one array
+ * of fixed-size nodes where the children of a node are contiguous, plus
+ * a pool of strings. Everything is owned by xtasm and only valid during
+ * the call. The code is written through the xt_sink, so no buffer ever
+ * changes owner.
+ *
+ * Since version 2 a plugin can ask for the lowered program instead (see
+ * compile_lir): a linear list of instructions with labels and branches,
+ * optimized with -O (peephole rules included), like the built-in x86_64
+ * backend gets it.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* bumped on every change of the tables, fields are only ever appended. */
+#define XT_ABI_VERSION 2
+/* oldest version still loaded (without the fields appended later). */
+#define XT_ABI_MIN_VERSION 1
+
+/* kinds of node, same values as Instr_Kind. */
+enum {
+    XT_DATA,
+    XT_CODE,
+    XT_LABEL,
+    XT_EXIT,
+    XT_ADD,
+    XT_SUB,
+    XT_MUL,
+    XT_MOV,
+    XT_JMP,
+    XT_BREAK,
+    XT_ENUM,
+    XT_WHILE,
+    XT_FOR,
+    XT_LOOP,
+    XT_IF,
+    XT_COND,
+    XT_VAR,
+    XT_TXT,
+};
+
+/* node of the program, same layout as Flat_Node. */
+typedef struct xt_node {
+    uint8_t kind;
+    uint8_t op;
+    uint8_t link;
+    uint8_t unused;
+    uint32_t first;
+    uint32_t count;
+    uint32_t value;
+    uint32_t extra;
+} xt_node;
+
+/* string of the pool (not '\0' terminated). */
+typedef struct xt_str {
+    const char *data;
+    uint32_t len;
+} xt_str;
+
+typedef struct xt_program {
+    const xt_node *nodes;
+    uint32_t node_count;
+    /* the top level instructions are nodes[0, top). */
+    uint32_t top;
+    const xt_str *strings;
+    uint32_t string_count;
+} xt_program;
+
+/* operations of the lowered instructions, same values as Lir_Op. */
+enum {
+    /* a: label. */
+    XT_LIR_LABEL,
+    /* a = b. */
+    XT_LIR_MOV,
+    /* a += b. */
+    XT_LIR_ADD,
+    /* a -= b. */
+    XT_LIR_SUB,
+    /* a *= b. */
+    XT_LIR_MUL,
+    /* a <<= b (an immediate below 64). */
+    XT_LIR_SHL,
+    /* goto a (label). */
+    XT_LIR_JMP,
+    /* if (a cond b) goto target. */
+    XT_LIR_BR,
+    /* terminates the program with a. */
+    XT_LIR_EXIT,
+};
+
+/* kinds of operand, same values as Operand_Kind. */
+enum {
+    XT_OPERAND_NONE,
+    /* machine register, numbered like the x86-64 encoding. */
+    XT_OPERAND_REG,
+    /* index of xt_lir_program.vars. */
+    XT_OPERAND_VAR,
+    XT_OPERAND_IMM,
+    /* index of xt_lir_program.labels. */
+    XT_OPERAND_LBL,
+};
+
+/* operand, same layout as Operand. */
+typedef struct xt_operand {
+    uint8_t kind;
+    int64_t value;
+} xt_operand;
+
+/* lowered instruction, same layout as Lir_Instr. */
+typedef struct xt_lir_instr {
+    uint8_t op;
+    /* comparison of a XT_LIR_BR, same values as the op of a XT_COND node. */
+    int32_t cond;
+    xt_operand a;
+    xt_operand b;
+    /* label reached by a XT_LIR_BR. */
+    uint32_t target;
+} xt_lir_instr;
+
+typedef struct xt_lir_var {
+    xt_str name;
+    /* initial value. */
+    int64_t value;
+    /* declared with '?' (or crafted by xtasm), no initial value. */
+    uint8_t bss;
+} xt_lir_var;
+
+typedef struct xt_lir_label {
+    xt_str name;
+    /* written by the user, otherwise crafted by xtasm. */
+    uint8_t user;
+} xt_lir_label;
+
+typedef struct xt_lir_program {
+    const xt_lir_instr *code;
+    uint32_t code_count;
+    const xt_lir_var *vars;
+    uint32_t var_count;
+    const xt_lir_label *labels;
+    uint32_t label_count;
+} xt_lir_program;
+
+/* destination of the code. */
+typedef struct xt_sink {
+    void *ctx;
+    void (*write)(void *ctx, const char *data, size_t len);
+} xt_sink;
+
+typedef struct xt_backend {
+    /* from XT_ABI_MIN_VERSION to XT_ABI_VERSION. */
+    /* below 2 the table may end before compile_lir, which is never read then. */
+    uint32_t abi_version;
+    const char *name;
+    /* called once when the plugin is loaded, the result is passed to every call (can be NULL). */
+    void *(*create)(void);
+    /* called once before the plugin is unloaded (can be NULL). */
+    void (*destroy)(void *state);
+    /* translates a program, returns 0 on success (can be NULL if compile_lir is given). */
+    int (*compile)(void *state, const xt_program *program, xt_sink *out);
+    /* since version 2 (can be NULL): translates the lowered program, used instead of compile. */
+    int (*compile_lir)(void *state, const xt_lir_program *program, xt_sink *out);
+} xt_backend;
+
+typedef const xt_backend *(*xt_backend_entry_fn)(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* XT_BACKEND_H */
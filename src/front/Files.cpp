@@ -0,0 +1,16 @@
+#include "Files.h"
+
+uint32_t File_Table::load(std::string filepath) {
+    // every load gets a fresh id, so a file modified between two loads
+    // never invalidates tokens that are still around.
+    auto source = std::make_unique<Source>();
+    source->open(filepath);
+
+    // tokens address their text with 32 bit offsets.
+    if (source->view().length() > UINT32_MAX) crash("Source file '" + filepath + "' is bigger than 4 GiB.");
+
+    this->paths.push_back(filepath);
+    this->sources.push_back(std::move(source));
+
+    return this->paths.size() - 1;
+}
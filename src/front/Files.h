@@ -0,0 +1,44 @@
+#ifndef FILES_H
+#define FILES_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Source.h"
+
+// Implementing the table of the loaded files as a singleton.
+// Every file is loaded once and stays alive until the end of the
+// program, so tokens can keep views over the source buffers and
+// refer to their file with a small id.
+class File_Table {
+    public:
+        // Deleting copy c'tor.
+        explicit File_Table(const File_Table &other) = delete;
+
+        // Used to get a File_Table reference.
+        static File_Table &get_table() {
+            static File_Table table;
+            return table;
+        }
+
+        // Used to load a file and obtain its id.
+        uint32_t load(std::string filepath);
+
+        // Used to get the path of a loaded file.
+        std::string &path(uint32_t id) { return this->paths[id]; }
+        // Used to get the content of a loaded file.
+        std::string_view content(uint32_t id) { return this->sources[id]->view(); }
+    private:
+        // Default c'tor.
+        File_Table() = default;
+
+        // path of every loaded file.
+        std::vector<std::string> paths;
+        // content of every loaded file.
+        std::vector<std::unique_ptr<Source>> sources;
+};
+
+#endif // FILES_H
@@ -0,0 +1,125 @@
+#ifndef KEYWORDS_H
+#define KEYWORDS_H
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+#include "Token.h"
+
+// Row of the keyword table.
+struct Keyword {
+    // text of the keyword.
+    std::string_view text;
+    // type of the token crafted from the keyword.
+    TokenType type;
+};
+
+// All the reserved words of the language.
+// Adding a new instruction only requires a new row.
+inline constexpr Keyword KEYWORDS[] = {
+    // Sections.
+    { "#code", TokenType::CODE  },
+    { "#data", TokenType::DATA  },
+    // Loops.
+    { "while", TokenType::WHILE },
+    { "for",   TokenType::FOR   },
+    { "loop",  TokenType::LOOP  },
+    { "break", TokenType::BREAK },
+    // Control flow.
+    { "if",    TokenType::IF    },
+    { "in",    TokenType::IN    },
+    { "else",  TokenType::ELSE  },
+    { "end",   TokenType::END   },
+    // Instructions.
+    { "exit",  TokenType::EXIT  },
+    { "add",   TokenType::ADD   },
+    { "sub",   TokenType::SUB   },
+    { "mul",   TokenType::MUL   },
+    { "mov",   TokenType::MOV   },
+    { "jmp",   TokenType::JMP   },
+    // Variables.
+    { "enum",  TokenType::ENUM  },
+};
+
+// Token types crafted only from a keyword.
+inline constexpr TokenType KEYWORD_TYPES[] = {
+    TokenType::CODE, TokenType::DATA,
+    TokenType::WHILE, TokenType::FOR, TokenType::LOOP, TokenType::BREAK,
+    TokenType::IF, TokenType::IN, TokenType::ELSE, TokenType::END,
+    TokenType::EXIT, TokenType::ADD, TokenType::SUB, TokenType::MUL, TokenType::MOV, TokenType::JMP,
+    TokenType::ENUM,
+};
+
+// Used to check that every keyword type has exactly one row, and every row one of them.
+constexpr bool keywords_complete() {
+    for (auto type : KEYWORD_TYPES) {
+        uint32_t rows = 0;
+        for (auto &kw : KEYWORDS) rows += kw.type == type;
+        if (rows != 1) return false;
+    }
+    return sizeof(KEYWORDS) / sizeof(Keyword) == sizeof(KEYWORD_TYPES) / sizeof(TokenType);
+}
+
+static_assert(keywords_complete(), "ERROR: the keyword table needs one row per keyword type!\n");
+
+// Perfect hash over the keyword table, everything is computed at compile time.
+namespace keyword_hash {
+    inline constexpr uint32_t COUNT = sizeof(KEYWORDS) / sizeof(Keyword);
+
+    // number of slots (power of two, at least twice the keywords).
+    inline constexpr uint32_t SIZE = [] {
+        uint32_t size = 1;
+        while (size < 2 * COUNT) size <<= 1;
+        return size;
+    }();
+
+    // FNV-1a mixed with a seed.
+    constexpr uint32_t hash(std::string_view text, uint32_t seed) {
+        uint32_t h = 2166136261u ^ seed;
+        for (char c : text) {
+            h ^= (uint8_t) c;
+            h *= 16777619u;
+        }
+        return h ^ (h >> 15);
+    }
+
+    // Used to check if a seed maps every keyword to a different slot.
+    constexpr bool is_perfect(uint32_t seed) {
+        std::array<bool, SIZE> used = {};
+        for (auto &kw : KEYWORDS) {
+            auto slot = hash(kw.text, seed) & (SIZE - 1);
+            if (used[slot]) return false;
+            used[slot] = true;
+        }
+        return true;
+    }
+
+    // first seed without collisions.
+    inline constexpr uint32_t SEED = [] {
+        uint32_t seed = 0;
+        while (seed < 1 << 16 && !is_perfect(seed)) seed++;
+        return seed;
+    }();
+
+    static_assert(is_perfect(SEED), "ERROR: unable to find a perfect hash for the keyword table!\n");
+
+    // slot -> index of the keyword + 1 (0 means empty).
+    inline constexpr std::array<uint8_t, SIZE> SLOTS = [] {
+        std::array<uint8_t, SIZE> slots = {};
+        for (uint32_t i = 0; i < COUNT; i++) {
+            slots[hash(KEYWORDS[i].text, SEED) & (SIZE - 1)] = i + 1;
+        }
+        return slots;
+    }();
+}
+
+// Used to get the type of a keyword.
+// Returns TokenType::INVALID if the text isn't a keyword.
+constexpr TokenType keyword_type(std::string_view text) {
+    auto slot = keyword_hash::SLOTS[keyword_hash::hash(text, keyword_hash::SEED) & (keyword_hash::SIZE - 1)];
+    if (!slot || KEYWORDS[slot - 1].text != text) return TokenType::INVALID;
+    return KEYWORDS[slot - 1].type;
+}
+
+#endif // KEYWORDS_H
@@ -1,62 +1,170 @@
 #include "Lexer.h"
 
+#include <algorithm>
 #include <cctype>
-#include <fstream>
-#include <stdexcept>
-#include <cerrno>
 #include <string>
+#include <thread>
 
+#include "Files.h"
+#include "Keywords.h"
+#include "Scan.h"
 #include "Token.h"
 
-std::vector<Token> Lexer::lex_file(std::string filepath) {
+TokenStream Lexer::lex_file(std::string filepath) {
     // reset the Lexer state.
     this->reset();
-    this->filepath = filepath;
+    this->load(filepath);
     
-    if (filepath.empty()) crash("No file provided.");
-    if (!filepath.ends_with(".xt")) crash("Invalid file extension. Expected '.xt'");
+    // tokenization.
+    TokenStream tkns(this->file);
+    this->lex(tkns);
+
+    return tkns;
+}
 
-    // read the content of the file.
-    std::ifstream file;
-    file.open(filepath);
+TokenStream Lexer::lex_file_parallel(std::string filepath, uint_t jobs) {
+    // reset the Lexer state.
+    this->reset();
+    this->load(filepath);
 
-    if (!file.is_open()) {
-        auto msg = "Unable to open '" + filepath + "'. " + std::strerror(errno);
-        crash(msg);
-    } 
+    if (!jobs) jobs = std::max(std::thread::hardware_concurrency(), 1u);
 
-    std::string line;
-    while (file.good()) {
-        std::getline(file, line);    
-        this->src += line + "\n";
+    // small chunks aren't worth a thread.
+    uint_t chunks = std::min(jobs, this->src.length() / MIN_CHUNK_SIZE);
+    if (chunks < 2) {
+        TokenStream tkns(this->file);
+        this->lex(tkns);
+        return tkns;
     }
-    file.close();
-    
+
+    // splitting the source after a '\n', no token spans multiple lines.
+    std::vector<Lexer> lexers(chunks);
+    uint_t begin = 0;
+
+    for (uint_t i = 0; i < chunks; i++) {
+        uint_t end = this->src.length();
+
+        if (i != chunks - 1) {
+            end = std::max(begin, this->src.length() / chunks * (i + 1));
+            end += scan::line_len(this->src.data() + end, this->end());
+            end = std::min(end + 1, this->src.length());
+        }
+
+        lexers[i].reset();
+        lexers[i].worker = true;
+        lexers[i].file = this->file;
+        lexers[i].src = this->src.substr(begin, end - begin);
+
+        begin = end;
+    }
+
     // tokenization.
-    std::vector<Token> tkns;
+    std::vector<TokenStream> results(chunks, TokenStream(this->file));
+    std::vector<std::thread> workers;
+
+    for (uint_t i = 0; i < chunks; i++) {
+        workers.emplace_back([&lexers, &results, i] { lexers[i].lex(results[i]); });
+    }
+
+    for (auto &worker : workers) worker.join();
+
+    // every chunk started from 1:1, moving its tokens where the previous
+    // chunks ended. Only the first line of a chunk continues a line.
+    auto place = [this](Token &tkn) {
+        if (tkn.line == 1) tkn.column += this->column - 1;
+        tkn.line += this->line - 1;
+    };
+
+    TokenStream tkns(this->file);
+    uint_t total = 0;
+    for (auto &result : results) total += result.size();
+    tkns.reserve(total);
+
+    for (uint_t i = 0; i < chunks; i++) {
+        // the first error in chunk order is the one the sequential lexer stops at.
+        if (lexers[i].error.is_some()) {
+            auto error = lexers[i].error.unwrap();
+            place(error.tkn);
+            crash(error.head + token_loc(error.tkn) + error.tail);
+        }
+
+        for (uint_t j = 0; j < results[i].size(); j++) {
+            auto tkn = results[i].token(j);
+            place(tkn);
+            tkns.push(tkn);
+        }
+
+        if (lexers[i].line == 1) this->column += lexers[i].column - 1;
+        else this->column = lexers[i].column;
+        this->line += lexers[i].line - 1;
+    }
+
+    return tkns;
+}
+
+void Lexer::lex_stream(std::string filepath, TokenPipe &pipe) {
+    // reset the Lexer state.
+    this->reset();
+    this->load(filepath);
+    this->worker = true;
+
+    // tokenization, a batch at a time.
+    TokenStream batch(this->file);
+    batch.reserve(BATCH_SIZE);
 
     while (true) {
         auto tkn = this->next();
         if (tkn.is_none()) break;
 
-        tkns.push_back(tkn.unwrap());
+        batch.push(tkn.unwrap());
+        if (batch.size() < BATCH_SIZE) continue;
+
+        pipe.push(std::move(batch));
+        batch = TokenStream(this->file);
+        batch.reserve(BATCH_SIZE);
     }
 
-    return tkns;
+    // the parser reports the error, its thread is the only one crashing.
+    if (this->error.is_some()) {
+        auto error = this->error.unwrap();
+        pipe.fail(error.head + token_loc(error.tkn) + error.tail);
+        return;
+    }
+
+    if (batch.size()) pipe.push(std::move(batch));
+    pipe.close();
+}
+
+void Lexer::load(std::string filepath) {
+    if (filepath.empty()) crash("No file provided.");
+    if (filepath != "-" && !filepath.ends_with(".xt")) crash("Invalid file extension. Expected '.xt'");
+
+    // loading the content of the file, it's scanned in place.
+    auto &files = File_Table::get_table();
+    this->file = files.load(filepath);
+    this->src = files.content(this->file);
+}
+
+void Lexer::lex(TokenStream &tkns) {
+    while (true) {
+        auto tkn = this->next();
+        if (tkn.is_none()) break;
+
+        tkns.push(tkn.unwrap());
+    }
 }
 
 Token Lexer::token() {
     // old_cursor points to the start of the token
     // cursor points to the char after the token
     auto text_len = this->cursor - this->old_cursor;
-    auto text = this->src.substr(this->old_cursor, text_len);
     
     Token tkn = (Token) {
         .type = TokenType::INVALID,
-        .text = text,
-        .file = this->filepath,
-        .line = this->line,
-        .column = this->column,
+        .file = this->file,
+        .line = (uint32_t) this->line,
+        .column = (uint32_t) this->column,
+        .text = this->src.substr(this->old_cursor, text_len),
     };
 
     // shifting forward the old_cursor to point after the token.
@@ -66,29 +174,19 @@ Token Lexer::token() {
 }
 
 Option<char> Lexer::peek(uint_t offset) {
-    try {
-        // if the cursor position is valid return the character.
-        return Option<char>::some(
-            this->src.at(this->cursor + offset)
-        );
-    } catch (std::out_of_range &e) {
-        // if the cursor position is invalid return None.
-        return Option<char>::none();
-    }
+    // if the cursor position is invalid return None.
+    if (this->cursor + offset >= this->src.length()) return Option<char>::none();
+
+    // the position has been checked, no need for `at`.
+    return Option<char>::some(this->src[this->cursor + offset]);
 }
 
 Option<char> Lexer::advance() {
     // if EOF is hitted return None.
     if (this->cursor >= this->src.length()) return Option<char>::none();
 
-    // technically this will never fail.
-    return Option<char>::some(this->src.at(this->cursor++));
-}
-
-void Lexer::new_line() {
-    // update line and column.
-    this->line++;
-    this->column = 1;
+    // the position has been checked, no need for `at`.
+    return Option<char>::some(this->src[this->cursor++]);
 }
 
 Option<Token> Lexer::next() {
@@ -100,21 +198,15 @@ Option<Token> Lexer::next() {
         switch (c) {
             case '#': {
                 // consume the token.
-                while (this->peek().is_some_and(
-                    [](char x) { return (x != ' ' && x != '\n'); }
-                )) {
-                    this->advance();
-                }
+                this->cursor += scan::field_len(this->here(), this->end());
 
                 auto tkn = this->token();
 
                 // token type recognition.
-                if (tkn.text == "#code") tkn.type = TokenType::CODE;
-                else if (tkn.text == "#data") tkn.type = TokenType::DATA;
-                else {
+                tkn.type = keyword_type(tkn.text);
+                if (tkn.type != TokenType::CODE && tkn.type != TokenType::DATA) {
                     // if here something wrong is inside the file.
-                    auto msg = token_loc(tkn) + " - unknown section '" + tkn.text + "'.";
-                    crash(msg);
+                    this->fail(tkn, "", " - unknown section '" + std::string(tkn.text) + "'.");
                 }
 
                 return Option<Token>::some(tkn);
@@ -122,15 +214,11 @@ Option<Token> Lexer::next() {
 
             case '$': {
                 // consume the token.
-                while (this->peek().is_some_and(
-                    [](char x) { return (x != ' ' && x != '\n'); }
-                )) {
-                    this->advance();
-                }
+                this->cursor += scan::field_len(this->here(), this->end());
 
                 auto tkn = this->token();
                 tkn.type = TokenType::REG;
-                tkn.text.replace(0, 1, "");
+                tkn.text.remove_prefix(1);
 
                 return Option<Token>::some(tkn);
             } break;
@@ -144,15 +232,11 @@ Option<Token> Lexer::next() {
             // label definition.
             case ':': {
                 // consume the token.
-                while (this->peek().is_some_and(
-                    [](char x) { return (x != ' ' && x != '\n'); }
-                )) {
-                    this->advance();
-                }
+                this->cursor += scan::field_len(this->here(), this->end());
 
                 auto tkn = this->token();
                 tkn.type = TokenType::LABEL;
-                tkn.text.replace(0, 1, "");
+                tkn.text.remove_prefix(1);
 
                 return Option<Token>::some(tkn);
             } break;
@@ -163,9 +247,7 @@ Option<Token> Lexer::next() {
                    [](char x) { return x == '='; }
                )) {
                    auto tkn = this->token();
-                   std::string msg = "Unexpected character '=' (Unfinished boolean equals)\n";
-                   msg += "\tfound at -- " + token_loc(tkn);
-                   crash(msg);
+                   this->fail(tkn, "Unexpected character '=' (Unfinished boolean equals)\n\tfound at -- ", "");
                }
                this->advance();
 
@@ -180,9 +262,7 @@ Option<Token> Lexer::next() {
                    [](char x) { return x == '='; }
                )) {
                    auto tkn = this->token();
-                   std::string msg = "Unexpected character '!' (Unfinished boolean not equals)\n";
-                   msg += "\tfound at -- " + token_loc(tkn);
-                   crash(msg);
+                   this->fail(tkn, "Unexpected character '!' (Unfinished boolean not equals)\n\tfound at -- ", "");
                }
                this->advance();
 
@@ -231,9 +311,7 @@ Option<Token> Lexer::next() {
                      [](char x) { return x == '&'; }
                 )) {
                      auto tkn = this->token();
-                     std::string msg = "Unexpected character '&' (Unfinished logical and)\n";
-                     msg += "\tfound at -- " + token_loc(tkn);
-                     crash(msg);
+                     this->fail(tkn, "Unexpected character '&' (Unfinished logical and)\n\tfound at -- ", "");
                 }
                 this->advance();
     
@@ -248,9 +326,7 @@ Option<Token> Lexer::next() {
                      [](char x) { return x == '|'; }
                 )) {
                      auto tkn = this->token();
-                     std::string msg = "Unexpected character '|' (Unfinished logical or)\n";
-                     msg += "\tfound at -- " + token_loc(tkn);
-                     crash(msg);
+                     this->fail(tkn, "Unexpected character '|' (Unfinished logical or)\n\tfound at -- ", "");
                 }
                 this->advance();
     
@@ -259,17 +335,23 @@ Option<Token> Lexer::next() {
                 return Option<Token>::some(tkn);
             } break;
 
-            // ignoring spaces.
+            // ignoring spaces and new lines.
             case ' ':
-                this->old_cursor++;
-                this->column++;
-                break;
-
-            // ignoring new lines.
-            case '\n':
-                this->old_cursor++;
-                this->new_line();
-                break;
+            case '\n': {
+                // the whole run is skipped at once, starting from c.
+                this->cursor--;
+                auto blank = scan::skip_blank(this->here(), this->end());
+
+                this->cursor += blank.len;
+                this->old_cursor += blank.len;
+
+                if (blank.new_lines) {
+                    this->line += blank.new_lines;
+                    this->column = 1 + blank.tail;
+                } else {
+                    this->column += blank.len;
+                }
+            } break;
             
             // ignoring comments.
             case '-': {
@@ -277,19 +359,13 @@ Option<Token> Lexer::next() {
                     [](char x) { return x == '-'; }
                 )) {
                     auto tkn = this->token();
-                    auto msg = "Unexpected character '-' (Unfinished comment prefix)\n\tfound at -- " + token_loc(tkn);
-                    crash(msg);
+                    this->fail(tkn, "Unexpected character '-' (Unfinished comment prefix)\n\tfound at -- ", "");
                 }
 
                 // consume the line untile '\n'.
-                while (this->peek().is_some_and(
-                    [](char x) { return x != '\n'; }
-                )) {
-                    this->old_cursor++;
-                    this->advance();
-                }
-
-                this->old_cursor++;
+                auto len = scan::line_len(this->here(), this->end());
+                this->cursor += len;
+                this->old_cursor += len + 1;
             } break;
 
             // variable initialization inside bss.
@@ -303,45 +379,24 @@ Option<Token> Lexer::next() {
                 // checking for keywords.
                 if (std::isalpha(c) || c == '.') {
                     // consuming the token.
-                    while (this->peek().is_some_and(
-                        [](char x) { return (bool) std::isalpha(x) || x == '_' || x == '.'; }
-                    )) {
-                        this->advance();
-                    }
+                    this->cursor += scan::word_len(this->here(), this->end());
 
                     auto tkn = this->token();
 
                     // checking word existence
                     
-                    if      (tkn.text.starts_with('.')) tkn.type = TokenType::VAR;
-                    // TODO: put here all the known instructions.
-                    else if (tkn.text == "exit")  tkn.type = TokenType::EXIT;
-                    else if (tkn.text == "add")   tkn.type = TokenType::ADD;
-                    else if (tkn.text == "sub")   tkn.type = TokenType::SUB;
-                    else if (tkn.text == "mul")   tkn.type = TokenType::MUL;
-                    else if (tkn.text == "mov")   tkn.type = TokenType::MOV;
-                    else if (tkn.text == "jmp")   tkn.type = TokenType::JMP;
-                    else if (tkn.text == "enum")  tkn.type = TokenType::ENUM;
-                    else if (tkn.text == "while") tkn.type = TokenType::WHILE;
-                    else if (tkn.text == "for")   tkn.type = TokenType::FOR;
-                    else if (tkn.text == "loop")  tkn.type = TokenType::LOOP;
-                    else if (tkn.text == "break") tkn.type = TokenType::BREAK;
-                    else if (tkn.text == "if")    tkn.type = TokenType::IF;
-                    else if (tkn.text == "in")    tkn.type = TokenType::IN;
-                    else if (tkn.text == "else")  tkn.type = TokenType::ELSE;
-                    else if (tkn.text == "end")   tkn.type = TokenType::END;
-                    else tkn.type = TokenType::NAME;
+                    if (tkn.text.starts_with('.')) tkn.type = TokenType::VAR;
+                    // known instructions are inside the keyword table.
+                    else tkn.type = keyword_type(tkn.text);
+
+                    if (tkn.type == TokenType::INVALID) tkn.type = TokenType::NAME;
                     
                     return Option<Token>::some(tkn);
                 } 
                 
                 if (std::isdigit(c)) {
                     // consuming the token.
-                    while (this->peek().is_some_and(
-                        [](char x) { return ((bool) std::isdigit(x) || x == '.'); }
-                    )) {
-                        this->advance();
-                    }
+                    this->cursor += scan::number_len(this->here(), this->end());
 
                     auto tkn = this->token();
 
@@ -356,18 +411,32 @@ Option<Token> Lexer::next() {
 
                     return Option<Token>::some(tkn);
                 }
+
+                // any other character is skipped, so it never ends up
+                // inside the text of the next token.
+                this->old_cursor++;
             } break;
         }
     }
     return Option<Token>::none();
 }
 
+void Lexer::fail(const Token &tkn, std::string head, std::string tail) {
+    if (!this->worker) crash(head + token_loc(tkn) + tail);
+
+    // the main thread crashes once the worker is joined (and knows where a chunk starts).
+    if (this->error.is_none()) this->error.insert({ tkn, std::move(head), std::move(tail) });
+    this->cursor = this->src.length();
+}
+
 void Lexer::reset() {
     // resetting Lexer state.
-    this->filepath.clear();
-    this->src.clear();
+    this->file = 0;
+    this->src = std::string_view();
     this->line = 1;
     this->column = 1;
     this->cursor = 0;
     this->old_cursor = 0;
+    this->worker = false;
+    this->error = Option<Error>::none();
 }
@@ -3,36 +3,67 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 
 #include "../shared/Basic.h"
 #include "../shared/Option.h"
 #include "Token.h"
+#include "TokenPipe.h"
+#include "TokenStream.h"
 
 class Lexer {
     public:
         // Default c'tor.
         explicit Lexer() {}
 
-        // Used to tokenize a file.
-        std::vector<Token> lex_file(std::string filepath);
+        // Used to tokenize a file ("-" means stdin).
+        TokenStream lex_file(std::string filepath);
+        // Used to tokenize a file splitting it in chunks lexed in parallel.
+        // jobs = 0 uses one thread per core. The tokens are the same of lex_file.
+        TokenStream lex_file_parallel(std::string filepath, uint_t jobs = 0);
+        // Used to tokenize a file pushing the tokens into a pipe in batches.
+        // The pipe is closed at the end (failed on an error), meant to run on its own thread.
+        void lex_stream(std::string filepath, TokenPipe &pipe);
     private:
+        // number of tokens inside a batch pushed by lex_stream.
+        static constexpr uint_t BATCH_SIZE = 4096;
+        // smallest chunk lexed by its own thread.
+        static constexpr uint_t MIN_CHUNK_SIZE = 1 << 20;
+
+        // Error found by a lexer on a worker thread, raised by the main thread.
+        struct Error {
+            // token the error is about.
+            Token tkn;
+            // message before and after the location of the token.
+            std::string head;
+            std::string tail;
+        };
+
+        // Used to load the file to tokenize.
+        void load(std::string filepath);
+        // Used to tokenize the source from the current state.
+        void lex(TokenStream &tkns);
         // Used to craft a token from the current state.
         Token token();
         // Used to peek the next character.
         Option<char> peek(uint_t offset = 0);
         // Used to advance the cursor.
         Option<char> advance(); 
-        // Used to handle a carriage return.
-        void new_line();
+        // Used to get a pointer to the cursor.
+        const char *here() { return this->src.data() + this->cursor; }
+        // Used to get a pointer past the end of the source.
+        const char *end() { return this->src.data() + this->src.length(); }
         // Used to get the next Token.
         Option<Token> next();
+        // Used to report an error about a token, a lexer on a worker thread keeps it and stops.
+        void fail(const Token &tkn, std::string head, std::string tail);
         // Used to reset the Lexer state.
         void reset();
 
-        // filepath.
-        std::string filepath;
-        // source code.
-        std::string src;
+        // id of the file inside the File_Table.
+        uint32_t file;
+        // source code (view over the loaded file).
+        std::string_view src;
         // current line.
         uint_t line;
         // current column.
@@ -41,6 +72,10 @@ class Lexer {
         uint_t cursor;
         // current token column.
         uint_t old_cursor;
+        // true if the lexer runs on a worker thread (-par chunks, -stream).
+        bool worker = false;
+        // first error found by the worker.
+        Option<Error> error = Option<Error>::none();
 };
 
 #endif // LEXER_H
@@ -5,12 +5,52 @@
 #include <string>
 #include <vector>
 
-std::vector<std::unique_ptr<Instr>> Parser::parse_tkns(std::vector<Token> tkns) {
+Instrs Parser::parse_tkns(TokenStream tkns) {
     // initializing the Parser.
-    this->tkns = tkns;
+    this->tkns = std::move(tkns);
+    this->cursor = 0;
+    this->pipe = nullptr;
 
+    return this->parse();
+}
+
+Instrs Parser::parse_stream(TokenPipe &pipe, std::thread &producer) {
+    // initializing the Parser, batches are pulled on demand.
+    this->tkns = TokenStream();
+    this->cursor = 0;
+    this->pipe = &pipe;
+    this->stream = &pipe;
+    this->producer = &producer;
+
+    auto ast = this->parse();
+    this->join();
+
+    return ast;
+}
+
+void Parser::join() {
+    if (!this->producer) return;
+
+    // the producer is never left blocked on a full pipe.
+    this->stream->abort();
+    this->producer->join();
+
+    auto error = this->stream->error();
+    this->pipe = this->stream = nullptr;
+    this->producer = nullptr;
+
+    // without -stream the lexer is done before parsing, its error comes first.
+    if (error.is_some()) crash(error.unwrap());
+}
+
+void Parser::fail(std::string msg) {
+    this->join();
+    crash(msg);
+}
+
+Instrs Parser::parse() {
     // parsing.
-    std::vector<std::unique_ptr<Instr>> ast; 
+    Instrs ast; 
 
     while (true) {
         // getting the next instruction.
@@ -25,24 +65,47 @@ std::vector<std::unique_ptr<Instr>> Parser::parse_tkns(std::vector<Token> tkns)
     return ast;
 }
 
-Option<Token> Parser::peek(uint_t offset) {
-    try {
-        // if the cursor position is valid return the character.
-        return Option<Token>::some(
-            this->tkns.at(this->cursor + offset)
-        );
-    } catch (std::out_of_range &e) {
-        // if the cursor position is invalid return None.
-        return Option<Token>::none();
+bool Parser::fill(uint_t offset) {
+    while (this->cursor + offset >= this->tkns.size()) {
+        // nothing else to pull.
+        if (!this->pipe) return false;
+
+        TokenStream batch;
+        if (!this->pipe->pop(batch)) {
+            this->pipe = nullptr;
+            return false;
+        }
+
+        // the window restarts from the first token not consumed yet.
+        if (this->cursor < this->tkns.size()) {
+            TokenStream window;
+            for (uint_t i = this->cursor; i < this->tkns.size(); i++) window.push(this->tkns.token(i));
+            for (uint_t i = 0; i < batch.size(); i++) window.push(batch.token(i));
+            batch = std::move(window);
+        }
+
+        this->tkns = std::move(batch);
+        this->cursor = 0;
     }
+
+    return true;
+}
+
+Option<TokenType> Parser::peek(uint_t offset) {
+    // if the cursor position is invalid return None.
+    if (this->cursor + offset >= this->tkns.size() && !this->fill(offset)) return Option<TokenType>::none();
+
+    // the position has been checked.
+    return Option<TokenType>::some(this->tkns.type(this->cursor + offset));
 }
 
 Option<Token> Parser::advance() {
     // checking if the end is reached.
-    if (this->cursor >= this->tkns.size()) return Option<Token>::none();
+    if (this->cursor >= this->tkns.size() && !this->fill(0)) return Option<Token>::none();
 
-    // technically this will never fail.
-    return Option<Token>::some(this->tkns[this->cursor++]);
+    // the position has been checked.
+    this->last = this->tkns.token(this->cursor++);
+    return Option<Token>::some(this->last);
 }
 
 std::unique_ptr<Instr> Parser::next() {
@@ -55,10 +118,10 @@ std::unique_ptr<Instr> Parser::next() {
             case TokenType::DATA: return this->parse_data();
             case TokenType::CODE: return this->parse_code();
             default: {
-                auto msg = "Unexpected token '" + tkn.text + "' (Not a valid instruction)\n";
+                auto msg = "Unexpected token '" + std::string(tkn.text) + "' (Not a valid instruction)\n";
                 msg += "\t\tfound at -- " + token_loc(tkn);
                 // crashing the compiler.
-                crash(msg);
+                this->fail(msg);
             } break;
         }
     }
@@ -69,15 +132,13 @@ std::unique_ptr<Instr> Parser::next() {
 
 std::unique_ptr<Data> Parser::parse_data() {
     // data section is empty.
-    std::vector<std::unique_ptr<Instr>> variables;
+    Instrs variables;
 
     // parsing the variables.
     while (this->peek().is_some_and(
-        [](Token x) { return x.type != TokenType::CODE; }
+        [](TokenType x) { return x != TokenType::CODE; }
     )) {
-        auto tkn = this->peek().unwrap();
-
-        switch (tkn.type) {
+        switch (this->peek().unwrap()) {
             case TokenType::VAR: {
                 auto var = this->parse_variable();
                 if (!var) break;
@@ -103,7 +164,7 @@ std::unique_ptr<Data> Parser::parse_data() {
     return std::make_unique<Data>(std::move(variables));
 }
 
-std::unique_ptr<Instr> Parser::parse(Token tkn) {
+std::unique_ptr<Instr> Parser::parse(const Token &tkn) {
     // switching all the possible instructions.
     switch (tkn.type) {
         case TokenType::LABEL: 
@@ -143,10 +204,10 @@ std::unique_ptr<Instr> Parser::parse(Token tkn) {
             return this->parse_break();
 
         default: {
-            std::string msg = "Unexpected token '" + tkn.text + "' (Not a valid instruction)\n";
+            std::string msg = "Unexpected token '" + std::string(tkn.text) + "' (Not a valid instruction)\n";
             msg += "\t\tfound at -- " + token_loc(tkn);
             // crashing the compiler.
-            crash(msg);
+            this->fail(msg);
         } break;
     }
 
@@ -155,11 +216,11 @@ std::unique_ptr<Instr> Parser::parse(Token tkn) {
 
 std::unique_ptr<Code> Parser::parse_code() {
     // code section is empty.
-    std::vector<std::unique_ptr<Instr>> instructions;
+    Instrs instructions;
 
     // parsing the instructions.
     while (this->peek().is_some_and(
-        [](Token x) { return x.type != TokenType::DATA; }
+        [](TokenType x) { return x != TokenType::DATA; }
     )) {
         // now it's safe.
         auto tkn = this->advance().unwrap();
@@ -177,9 +238,9 @@ std::unique_ptr<Exit> Parser::parse_exit() {
     // checking for a value.
     if (this->peek().is_none()) {
         std::string msg = "Missing value for EXIT instruction\n\tfound at -- ";
-        msg += token_loc(this->tkns[this->cursor - 1]);
+        msg += token_loc(this->last);
         // crashing the compiler.
-        crash(msg);
+        this->fail(msg);
     }
 
     std::unique_ptr<Instr> value;
@@ -202,10 +263,10 @@ std::unique_ptr<Exit> Parser::parse_exit() {
 
             default: {
                 std::string msg = "Invalid parameter used for EXIT instruction\n";
-                msg += "\tfound -- '" + tkn.text + "'\n";
+                msg += "\tfound -- '" + std::string(tkn.text) + "'\n";
                 msg += "\tat    -- " + token_loc(tkn);
                 // crashing the compiler.
-                crash(msg);
+                this->fail(msg);
             } break;
         }
     }
@@ -220,31 +281,31 @@ std::unique_ptr<Var> Parser::parse_variable() {
 
     // checking for a valid variable.
     if (this->peek().is_some_and(
-        [](Token x) { return x.type != TokenType::VAR; }
+        [](TokenType x) { return x != TokenType::VAR; }
     )) {
-        // now it's a safe unwrapping, no need to consume.
-        auto tkn = this->peek().unwrap();
+        // now it's a safe read, no need to consume.
+        auto tkn = this->tkns.token(this->cursor);
         std::string msg = "Invalid variable declaration\n";
-        msg += "\tfound -- '" + tkn.text + "'\n";
+        msg += "\tfound -- '" + std::string(tkn.text) + "'\n";
         msg += "\tat    -- " + token_loc(tkn);
         // crashing the compiler.
-        crash(msg);
+        this->fail(msg);
     }
 
     // this is a safe, variable name already checked.
     // removing the '.' from the variable name.
-    std::string name = this->advance().unwrap().text.erase(0, 1);
+    std::string name = std::string(this->advance().unwrap().text.substr(1));
     // maybe there isn't a value, so initializing it with an empty string.
     std::string value = "";
 
     if (this->peek().is_none()) {
         std::string msg = "Missing value for variable '" + name + "'\n\tfound at -- ";
-        msg += token_loc(this->tkns[this->cursor - 1]);
+        msg += token_loc(this->last);
         // crashing the compiler.
-        crash(msg);
+        this->fail(msg);
     }
 
-    auto tkn = this->peek().unwrap();
+    auto tkn = this->tkns.token(this->cursor);
     switch (tkn.type) {
         case TokenType::INT:
             value = tkn.text;
@@ -256,10 +317,10 @@ std::unique_ptr<Var> Parser::parse_variable() {
 
         default: {
             std::string msg = "Invalid value for variable '" + name + "'\n";
-            msg += "\tfound -- '" + this->peek().unwrap().text + "'\n";
+            msg += "\tfound -- '" + std::string(tkn.text) + "'\n";
             msg += "\tat    -- " + token_loc(tkn);
             // crashing the compiler.
-            crash(msg);
+            this->fail(msg);
         } break;
     }
 
@@ -272,9 +333,9 @@ std::unique_ptr<Add> Parser::parse_add() {
     // checking for a value.
     if (this->peek().is_none()) {
         std::string msg = "Missing values for ADD instruction\n\tfound at -- ";
-        msg += token_loc(this->tkns[this->cursor - 1]);
+        msg += token_loc(this->last);
         // crashing the compiler.
-        crash(msg);
+        this->fail(msg);
     }
 
     std::unique_ptr<Instr> lhs;
@@ -297,10 +358,10 @@ std::unique_ptr<Add> Parser::parse_add() {
 
             default: {
                 std::string msg = "Invalid left hand side for ADD instruction\n";
-                msg += "\tfound -- '" + tkn.text + "'\n";
+                msg += "\tfound -- '" + std::string(tkn.text) + "'\n";
                 msg += "\tat    -- " + token_loc(tkn);
                 // crashing the compiler.
-                crash(msg);
+                this->fail(msg);
             } break;
         }
     }
@@ -323,10 +384,10 @@ std::unique_ptr<Add> Parser::parse_add() {
 
             default: {
                 std::string msg = "Invalid right hand side for ADD instruction\n";
-                msg += "\tfound -- '" + tkn.text + "'\n";
+                msg += "\tfound -- '" + std::string(tkn.text) + "'\n";
                 msg += "\tat    -- " + token_loc(tkn);
                 // crashing the compiler.
-                crash(msg);
+                this->fail(msg);
             } break;
         }
     }
@@ -339,9 +400,9 @@ std::unique_ptr<Sub> Parser::parse_sub() {
     // checking for a value.
     if (this->peek().is_none()) {
         std::string msg = "Missing values for SUB instruction\n\tfound at -- ";
-        msg += token_loc(this->tkns[this->cursor - 1]);
+        msg += token_loc(this->last);
         // crashing the compiler.
-        crash(msg);
+        this->fail(msg);
     }
 
     std::unique_ptr<Instr> lhs;
@@ -364,10 +425,10 @@ std::unique_ptr<Sub> Parser::parse_sub() {
 
             default: {
                 std::string msg = "Invalid left hand side for SUB instruction\n";
-                msg += "\tfound -- '" + tkn.text + "'\n";
+                msg += "\tfound -- '" + std::string(tkn.text) + "'\n";
                 msg += "\tat    -- " + token_loc(tkn);
                 // crashing the compiler.
-                crash(msg);
+                this->fail(msg);
             } break;
         }
     }
@@ -390,10 +451,10 @@ std::unique_ptr<Sub> Parser::parse_sub() {
 
             default: {
                 std::string msg = "Invalid right hand side for SUB instruction\n";
-                msg += "\tfound -- '" + tkn.text + "'\n";
+                msg += "\tfound -- '" + std::string(tkn.text) + "'\n";
                 msg += "\tat    -- " + token_loc(tkn);
                 // crashing the compiler.
-                crash(msg);
+                this->fail(msg);
             } break;
         }
     }
@@ -406,9 +467,9 @@ std::unique_ptr<Mul> Parser::parse_mul() {
 
     if (this->peek().is_none()) {
         std::string msg = "Missing values for MUL instruction\n\tfound at -- ";
-        msg += token_loc(this->tkns[this->cursor - 1]);
+        msg += token_loc(this->last);
         // crashing the compiler.
-        crash(msg);
+        this->fail(msg);
     
     }
 
@@ -432,10 +493,10 @@ std::unique_ptr<Mul> Parser::parse_mul() {
 
             default: {
                 std::string msg = "Invalid destination for MUL instruction\n";
-                msg += "\tfound -- '" + tkn.text + "'\n";
+                msg += "\tfound -- '" + std::string(tkn.text) + "'\n";
                 msg += "\tat    -- " + token_loc(tkn);
                 // crashing the compiler.
-                crash(msg);
+                this->fail(msg);
             } break;
         }
     }
@@ -458,10 +519,10 @@ std::unique_ptr<Mul> Parser::parse_mul() {
 
             default: {
                 std::string msg = "Invalid source for MOV instruction\n";
-                msg += "\tfound -- '" + tkn.text + "'\n";
+                msg += "\tfound -- '" + std::string(tkn.text) + "'\n";
                 msg += "\tat    -- " + token_loc(tkn);
                 // crashing the compiler.
-                crash(msg);
+                this->fail(msg);
             } break;
         }
     }
@@ -474,9 +535,9 @@ std::unique_ptr<Mov> Parser::parse_mov() {
     // checking for a value.
     if (this->peek().is_none()) {
         std::string msg = "Missing values for MOV instruction\n\tfound at -- ";
-        msg += token_loc(this->tkns[this->cursor - 1]);
+        msg += token_loc(this->last);
         // crashing the compiler.
-        crash(msg);
+        this->fail(msg);
     }
 
     std::unique_ptr<Instr> dst;
@@ -499,10 +560,10 @@ std::unique_ptr<Mov> Parser::parse_mov() {
 
             default: {
                 std::string msg = "Invalid destination for MOV instruction\n";
-                msg += "\tfound -- '" + tkn.text + "'\n";
+                msg += "\tfound -- '" + std::string(tkn.text) + "'\n";
                 msg += "\tat    -- " + token_loc(tkn);
                 // crashing the compiler.
-                crash(msg);
+                this->fail(msg);
             } break;
         }
     }
@@ -525,10 +586,10 @@ std::unique_ptr<Mov> Parser::parse_mov() {
 
             default: {
                 std::string msg = "Invalid source for MOV instruction\n";
-                msg += "\tfound -- '" + tkn.text + "'\n";
+                msg += "\tfound -- '" + std::string(tkn.text) + "'\n";
                 msg += "\tat    -- " + token_loc(tkn);
                 // crashing the compiler.
-                crash(msg);
+                this->fail(msg);
             } break;
         }
     }
@@ -541,20 +602,20 @@ std::unique_ptr<Jmp> Parser::parse_jmp() {
 
     if (this->peek().is_none()) {
         std::string msg = "Missing target for JMP instruction\n";
-        msg += "\tfound at -- " + token_loc(this->tkns[this->cursor - 1]);
+        msg += "\tfound at -- " + token_loc(this->last);
         // crashing the compiler.
-        crash(msg);
+        this->fail(msg);
     }
 
     if (!this->peek().is_some_and(
-        [](Token x) { return x.type == TokenType::LABEL; }
+        [](TokenType x) { return x == TokenType::LABEL; }
     )) {
         auto tkn = this->advance().unwrap();
         std::string msg = "Invalid target for JMP instruction (Not a label)\n";
-        msg += "\tfound -- '" + tkn.text + "'\n";
+        msg += "\tfound -- '" + std::string(tkn.text) + "'\n";
         msg += "\tat    -- " + token_loc(tkn);
         // crashing the compiler.
-        crash(msg);
+        this->fail(msg);
     }
 
     // now it's safe.
@@ -572,35 +633,35 @@ std::unique_ptr<Enum_Var> Parser::parse_enum() {
     // enum error.
     if (this->peek().is_none()) {
         std::string msg = "Missing name for ENUM instruction\n\tfound at -- ";
-        msg += token_loc(this->tkns[this->cursor - 1]);
+        msg += token_loc(this->last);
         // crashing the compiler.
-        crash(msg);
+        this->fail(msg);
     }
 
-    auto name = this->advance().unwrap().text;
+    auto name = std::string(this->advance().unwrap().text);
 
-    std::vector<std::unique_ptr<Instr>> values;
+    Instrs values;
     int enum_index = 0;
     while (!this->peek().is_some_and(
-        [](Token x) { return x.type == TokenType::END; }
+        [](TokenType x) { return x == TokenType::END; }
     )) {
         auto tkn_name = this->advance().unwrap();
 
         if (tkn_name.type != TokenType::VAR) {
-            std::string msg = "Invalid value for ENUM declaration.\n\tfound -- '" + tkn_name.text + "'\n";
+            std::string msg = "Invalid value for ENUM declaration.\n\tfound -- '" + std::string(tkn_name.text) + "'\n";
             msg += "\tat -- " + token_loc(tkn_name);
             // crashing the compiler.
-            crash(msg);
+            this->fail(msg);
         }
 
         if (this->peek().is_some_and( 
-                [](Token x) { return x.type == TokenType::INT; } 
+                [](TokenType x) { return x == TokenType::INT; } 
         )) {
-            enum_index = std::stoi(this->advance().unwrap().text);
+            enum_index = std::stoi(std::string(this->advance().unwrap().text));
         }
 
         // crafting a name like '.enum_name.var_name'.
-        auto var_name = name + tkn_name.text;
+        auto var_name = name + std::string(tkn_name.text);
 
         values.push_back(std::make_unique<Var>(
             var_name, std::to_string(enum_index), true
@@ -611,12 +672,12 @@ std::unique_ptr<Enum_Var> Parser::parse_enum() {
 
     // consuming the END token.
     if (!this->peek().is_some_and(
-        [](Token x) { return x.type == TokenType::END; }
+        [](TokenType x) { return x == TokenType::END; }
     )) {
         std::string msg = "Missing END token for ENUM declaration\n\tfound at -- ";
-        msg += token_loc(this->tkns[this->cursor - 1]);
+        msg += token_loc(this->last);
         // crashing the compiler.
-        crash(msg);
+        this->fail(msg);
     } 
    
     this->advance();
@@ -627,11 +688,11 @@ std::unique_ptr<Enum_Var> Parser::parse_enum() {
 std::unique_ptr<If> Parser::parse_if() {
     // checking for a condition.
     // if the condition is missing, parse_cond() will handle it.
-    std::vector<std::unique_ptr<Instr>> conditions;
-    std::vector<Bool_Op> bool_ops;
+    Instrs conditions;
+    Bool_Ops bool_ops;
 
     while (!this->peek().is_some_and(
-        [](Token x) { return x.type == TokenType::IN; }
+        [](TokenType x) { return x == TokenType::IN; }
     )) {
         auto cond = this->parse_cond();
 
@@ -639,14 +700,14 @@ std::unique_ptr<If> Parser::parse_if() {
 
         if (this->peek().is_none()) {
             std::string msg = "Missing 'IN' keyword for IF instruction\n\tfound at -- ";
-            msg += token_loc(this->tkns[this->cursor - 1]);
+            msg += token_loc(this->last);
             // crashing the compiler.
-            crash(msg);
+            this->fail(msg);
         }
 
         // checking for a boolean operator.
         if (this->peek().is_some_and(
-            [](Token x) { return x.type == TokenType::AND || x.type == TokenType::OR; }
+            [](TokenType x) { return x == TokenType::AND || x == TokenType::OR; }
         )) {
             auto tkn = this->advance().unwrap();
 
@@ -664,7 +725,7 @@ std::unique_ptr<If> Parser::parse_if() {
                     std::string msg = "Invalid boolean operator (Only && , || are valid)\n\tfound at -- ";
                     msg += token_loc(tkn);
                     // crashing the compiler.
-                    crash(msg);
+                    this->fail(msg);
                 } break;
             }
 
@@ -674,22 +735,22 @@ std::unique_ptr<If> Parser::parse_if() {
 
     // checking for IN keyword.
     if (!this->peek().is_some_and(
-        [](Token x) { return x.type == TokenType::IN; }
+        [](TokenType x) { return x == TokenType::IN; }
     )) {
         std::string msg = "Missing 'IN' keyword for IF instruction\n\tfound at -- ";
-        msg += token_loc(this->tkns[this->cursor - 1]);
+        msg += token_loc(this->last);
         // crashing the compiler.
-        crash(msg);
+        this->fail(msg);
     }
 
     // consuming the IN keyword.
     this->advance();
 
     // consuming the if body.
-    std::vector<std::unique_ptr<Instr>> if_body;
+    Instrs if_body;
 
     while (this->peek().is_some_and(
-        [](Token x) { return x.type != TokenType::ELSE && x.type != TokenType::END; }
+        [](TokenType x) { return x != TokenType::ELSE && x != TokenType::END; }
     )) {
         // now it's safe.
         auto tkn = this->advance().unwrap();
@@ -702,9 +763,9 @@ std::unique_ptr<If> Parser::parse_if() {
 
     if (this->peek().is_none()) {
         std::string msg = "Missing closing token for IF instruction\n\tfound at -- ";
-        msg += token_loc(this->tkns[this->cursor - 1]);
+        msg += token_loc(this->last);
         // crashing the compiler.
-        crash(msg);
+        this->fail(msg);
     }
 
     // now it's safe.
@@ -713,7 +774,7 @@ std::unique_ptr<If> Parser::parse_if() {
     // consuming the else body.
 
     // if END is encountered, there is no else body.
-    std::vector<std::unique_ptr<Instr>> else_body;
+    Instrs else_body;
 
     if (tkn.type == TokenType::END) {
         return std::make_unique<If>(std::move(conditions), bool_ops, std::move(if_body), std::move(else_body));
@@ -721,7 +782,7 @@ std::unique_ptr<If> Parser::parse_if() {
 
     // checking for an else if statement.
     if (this->peek().is_some_and(
-        [](Token x) { return x.type == TokenType::IF; }
+        [](TokenType x) { return x == TokenType::IF; }
     )) {
         this->advance();
 
@@ -733,7 +794,7 @@ std::unique_ptr<If> Parser::parse_if() {
 
     // otherwise, there is an else body.
     while (this->peek().is_some_and(
-        [](Token x) { return x.type != TokenType::END; }
+        [](TokenType x) { return x != TokenType::END; }
     )) {
         // now it's safe.
         auto tkn = this->advance().unwrap();
@@ -752,11 +813,11 @@ std::unique_ptr<If> Parser::parse_if() {
 
 std::unique_ptr<While> Parser::parse_while() {
 
-    std::vector<std::unique_ptr<Instr>> conditions;
-    std::vector<Bool_Op> bool_ops;
+    Instrs conditions;
+    Bool_Ops bool_ops;
 
     while (!this->peek().is_some_and(
-        [](Token x) { return x.type == TokenType::IN; }
+        [](TokenType x) { return x == TokenType::IN; }
     )) {
         auto cond = this->parse_cond();
 
@@ -764,14 +825,14 @@ std::unique_ptr<While> Parser::parse_while() {
 
         if (this->peek().is_none()) {
             std::string msg = "Missing 'IN' keyword for IF instruction\n\tfound at -- ";
-            msg += token_loc(this->tkns[this->cursor - 1]);
+            msg += token_loc(this->last);
             // crashing the compiler.
-            crash(msg);
+            this->fail(msg);
         }
 
         // checking for a boolean operator.
         if (this->peek().is_some_and(
-            [](Token x) { return x.type == TokenType::AND || x.type == TokenType::OR; }
+            [](TokenType x) { return x == TokenType::AND || x == TokenType::OR; }
         )) {
             auto tkn = this->advance().unwrap();
 
@@ -789,7 +850,7 @@ std::unique_ptr<While> Parser::parse_while() {
                     std::string msg = "Invalid boolean operator (Only && , || are valid)\n\tfound at -- ";
                     msg += token_loc(tkn);
                     // crashing the compiler.
-                    crash(msg);
+                    this->fail(msg);
                 } break;
             }
 
@@ -799,22 +860,22 @@ std::unique_ptr<While> Parser::parse_while() {
 
     // checking for IN keyword.
     if (!this->peek().is_some_and(
-        [](Token x) { return x.type == TokenType::IN; }
+        [](TokenType x) { return x == TokenType::IN; }
     )) {
         std::string msg = "Missing 'IN' keyword for WHILE instruction\n\tfound at -- ";
-        msg += token_loc(this->tkns[this->cursor - 1]);
+        msg += token_loc(this->last);
         // crashing the compiler.
-        crash(msg);
+        this->fail(msg);
     }
 
     // consuming the IN keyword.
     this->advance();
 
     // consuming the while body.
-    std::vector<std::unique_ptr<Instr>> body;
+    Instrs body;
 
     while (!this->peek().is_some_and(
-        [](Token x) { return x.type == TokenType::END; }
+        [](TokenType x) { return x == TokenType::END; }
     )) {
         // now it's safe.
         auto tkn = this->advance().unwrap();
@@ -827,9 +888,9 @@ std::unique_ptr<While> Parser::parse_while() {
 
     if (this->peek().is_none()) {
         std::string msg = "Missing closing token for WHILE instruction\n\tfound at -- ";
-        msg += token_loc(this->tkns[this->cursor - 1]);
+        msg += token_loc(this->last);
         // crashing the compiler.
-        crash(msg);
+        this->fail(msg);
     }
     
     // consuming the END token.
@@ -843,7 +904,7 @@ std::unique_ptr<For> Parser::parse_for() {
     std::unique_ptr<Instr> range_left;
     std::unique_ptr<Instr> range_right;
     std::unique_ptr<Instr> increment;
-    std::vector<std::unique_ptr<Instr>> body;
+    Instrs body;
 
     // checking for a valid range_left.
     if (this->peek().is_some()) {
@@ -863,22 +924,22 @@ std::unique_ptr<For> Parser::parse_for() {
 
             default: {
                 std::string msg = "Invalid range lower bound for FOR instruction\n";
-                msg += "\tfound -- '" + tkn.text + "'\n";
+                msg += "\tfound -- '" + std::string(tkn.text) + "'\n";
                 msg += "\tat    -- " + token_loc(tkn);
                 // crashing the compiler.
-                crash(msg);
+                this->fail(msg);
             } break;
         }
     }
 
     // checking for range separator.
     if (!this->peek().is_some_and(
-        [](Token x) { return x.type == TokenType::SEMICOLON; }
+        [](TokenType x) { return x == TokenType::SEMICOLON; }
     )) {
         std::string msg = "Missing ';' separator inside FOR instruction\n\tfound at -- ";
-        msg += token_loc(this->tkns[this->cursor - 1]);
+        msg += token_loc(this->last);
         // crashing the compiler.
-        crash(msg);
+        this->fail(msg);
     }
     
     // consuming the separator.
@@ -902,22 +963,22 @@ std::unique_ptr<For> Parser::parse_for() {
 
             default: {
                 std::string msg = "Invalid range upper bound for FOR instruction\n";
-                msg += "\tfound -- '" + tkn.text + "'\n";
+                msg += "\tfound -- '" + std::string(tkn.text) + "'\n";
                 msg += "\tat    -- " + token_loc(tkn);
                 // crashing the compiler.
-                crash(msg);
+                this->fail(msg);
             } break;
         }
     }
 
     // checking for range separator.
     if (!this->peek().is_some_and(
-        [](Token x) { return x.type == TokenType::SEMICOLON; }
+        [](TokenType x) { return x == TokenType::SEMICOLON; }
     )) {
         std::string msg = "Missing ';' separator inside FOR instruction\n\tfound at -- ";
-        msg += token_loc(this->tkns[this->cursor - 1]);
+        msg += token_loc(this->last);
         // crashing the compiler.
-        crash(msg);
+        this->fail(msg);
     }
 
     // consuming the separator.
@@ -941,29 +1002,29 @@ std::unique_ptr<For> Parser::parse_for() {
 
             default: {
                 std::string msg = "Invalid range increment for FOR instruction\n";
-                msg += "\tfound -- '" + tkn.text + "'\n";
+                msg += "\tfound -- '" + std::string(tkn.text) + "'\n";
                 msg += "\tat    -- " + token_loc(tkn);
                 // crashing the compiler.
-                crash(msg);
+                this->fail(msg);
             } break;
         }
     }
 
     // checking for IN keyword.
     if (!this->peek().is_some_and(
-        [](Token x) { return x.type == TokenType::IN; }
+        [](TokenType x) { return x == TokenType::IN; }
     )) {
         std::string msg = "Missing 'IN' keyword for FOR instruction\n\tfound at -- ";
-        msg += token_loc(this->tkns[this->cursor - 1]);
+        msg += token_loc(this->last);
         // crashing the compiler.
-        crash(msg);
+        this->fail(msg);
     }
     
     // consuming the IN keyword.
     this->advance();
 
     while (!this->peek().is_some_and(
-        [](Token x) { return x.type == TokenType::END; }
+        [](TokenType x) { return x == TokenType::END; }
     )) {
         // now it's safe.
         auto tkn = this->advance().unwrap();
@@ -976,9 +1037,9 @@ std::unique_ptr<For> Parser::parse_for() {
 
     if (this->peek().is_none()) {
         std::string msg = "Missing closing token for FOR instruction\n\tfound at -- ";
-        msg += token_loc(this->tkns[this->cursor - 1]);
+        msg += token_loc(this->last);
         // crashing the compiler.
-        crash(msg);
+        this->fail(msg);
     }
     
     // consuming the END token.
@@ -989,10 +1050,10 @@ std::unique_ptr<For> Parser::parse_for() {
 
 std::unique_ptr<Loop> Parser::parse_loop() {
 
-    std::vector<std::unique_ptr<Instr>> body;
+    Instrs body;
 
     while (!this->peek().is_some_and(
-        [](Token x) { return x.type == TokenType::END; }
+        [](TokenType x) { return x == TokenType::END; }
     )) {
         // now it's safe.
         auto tkn = this->advance().unwrap();
@@ -1005,9 +1066,9 @@ std::unique_ptr<Loop> Parser::parse_loop() {
 
     if (this->peek().is_none()) {
         std::string msg = "Missing closing token for FOR instruction\n\tfound at -- ";
-        msg += token_loc(this->tkns[this->cursor - 1]);
+        msg += token_loc(this->last);
         // crashing the compiler.
-        crash(msg);
+        this->fail(msg);
     }
     
     // consuming the END token.
@@ -1021,9 +1082,9 @@ std::unique_ptr<Cond> Parser::parse_cond() {
     // validating the lhs.
     if (this->peek().is_none()) {
         std::string msg = "Incomplete condition\n\tfound at -- ";
-        msg += token_loc(this->tkns[this->cursor - 1]);
+        msg += token_loc(this->last);
         // crashing the compiler.
-        crash(msg);
+        this->fail(msg);
     }
 
     auto lhs_tkn = this->advance().unwrap();
@@ -1042,18 +1103,18 @@ std::unique_ptr<Cond> Parser::parse_cond() {
 
         default: {
             std::string msg = "Invalid left hand side for condition (Expected variable, register or value)\n";
-            msg += "\tfound -- '" + lhs_tkn.text + "'\n";
+            msg += "\tfound -- '" + std::string(lhs_tkn.text) + "'\n";
             msg += "\tat    -- " + token_loc(lhs_tkn);
             // crashing the compiler.
-            crash(msg);
+            this->fail(msg);
         } break;
     }
 
     if (this->peek().is_none()) {
         std::string msg = "Missing operator for the condition\n\tfound at -- ";
-        msg += token_loc(this->tkns[this->cursor - 1]);
+        msg += token_loc(this->last);
         // crashing the compiler.
-        crash(msg);
+        this->fail(msg);
     }
 
     // validating the operator.
@@ -1089,38 +1150,38 @@ std::unique_ptr<Cond> Parser::parse_cond() {
             std::string msg = "Invalid boolean operator (Only == , != , > , >= are valid)\n\tfound at -- ";
             msg += token_loc(op_tkn);
             // crashing the compiler.
-            crash(msg);
+            this->fail(msg);
         } break;
     }
 
     // validating the rhs.
     if (this->peek().is_none()) {
         std::string msg = "Missing right hand side of the condition\n\tfound at -- ";
-        msg += token_loc(this->tkns[this->cursor - 1]);
+        msg += token_loc(this->last);
         // crashing the compiler.
-        crash(msg);
+        this->fail(msg);
     }
 
     auto rhs_tkn = this->advance().unwrap();
     std::unique_ptr<Instr> rhs;
 
-    switch (lhs_tkn.type) {
+    switch (rhs_tkn.type) {
         case TokenType::VAR: 
-            lhs = std::make_unique<Var>(rhs_tkn.text, "", false);
+            rhs = std::make_unique<Var>(rhs_tkn.text, "", false);
             break;
 
         case TokenType::REG:
         // TODO: add here other possible values.
         case TokenType::INT:
-            lhs = std::make_unique<Txt>(rhs_tkn.text);
+            rhs = std::make_unique<Txt>(rhs_tkn.text);
             break;
 
         default: {
             std::string msg = "Invalid right hand side for condition (Expected variable, register or value)\n";
-            msg += "\tfound -- '" + lhs_tkn.text + "'\n";
+            msg += "\tfound -- '" + std::string(rhs_tkn.text) + "'\n";
             msg += "\tat    -- " + token_loc(rhs_tkn);
             // crashing the compiler.
-            crash(msg);
+            this->fail(msg);
         } break;
     }
 
@@ -1131,7 +1192,7 @@ std::unique_ptr<Cond> Parser::parse_cond() {
                 std::string msg = "Invalid condition (Both sides can't be values)\n\tfound at -- ";
                 msg += token_loc(rhs_tkn);
                 // crashing the compiler.
-                crash(msg);
+                this->fail(msg);
             } break;
         
             default: 
@@ -2,11 +2,14 @@
 #define PARSER_H
 
 #include <memory>
+#include <thread>
 #include <vector>
 
 #include "../shared/Basic.h"
 #include "../shared/Option.h"
 #include "Token.h"
+#include "TokenPipe.h"
+#include "TokenStream.h"
 #include "../InstructionSet.h"
 
 class Parser {
@@ -15,10 +18,22 @@ class Parser {
         explicit Parser() = default;
 
         // Used to parse the tokens into instructions.
-        std::vector<std::unique_ptr<Instr>> parse_tkns(std::vector<Token> tkns);
+        Instrs parse_tkns(TokenStream tkns);
+        // Used to parse the tokens while the producer thread pushes them into a pipe.
+        // Only the batches around the cursor are kept in memory. The producer
+        // is joined before returning, its error (if any) wins over the parser ones.
+        Instrs parse_stream(TokenPipe &pipe, std::thread &producer);
     private:
-        // Used to peek the next token.
-        Option<Token> peek(uint_t offset = 0);
+        // Used to parse every instruction.
+        Instrs parse();
+        // Used to stop and join the producer, crashing on its error.
+        void join();
+        // Used to report a parse error, once the producer is joined.
+        void fail(std::string msg);
+        // Used to pull batches from the pipe until the token at offset is available.
+        bool fill(uint_t offset);
+        // Used to peek the type of the next token (only the type array is touched).
+        Option<TokenType> peek(uint_t offset = 0);
         // Used to advance and retrive the current token.
         Option<Token> advance();
         // Used to obtain the next instruction.
@@ -26,7 +41,7 @@ class Parser {
         // Used to parse the #data section.
         std::unique_ptr<Data> parse_data();
         // Used to parse the next instruction.
-        std::unique_ptr<Instr> parse(Token tkn);
+        std::unique_ptr<Instr> parse(const Token &tkn);
         // Used to parse the #code section.
         std::unique_ptr<Code> parse_code();
         // Used to parse an exit instruction.
@@ -61,10 +76,17 @@ class Parser {
 
         // LABELS ARE HANDLED INSIDE 'parse_code()' METHOD.
 
-        // The program represented as tokens.
-        std::vector<Token> tkns;
-        // Current token inside the vector.
+        // The program represented as tokens (a window of it when streaming).
+        TokenStream tkns;
+        // Current token inside the stream.
         uint_t cursor;
+        // Last consumed token (used for error reporting).
+        Token last;
+        // Source of the next batches (nullptr if everything is in tkns).
+        TokenPipe *pipe = nullptr;
+        // Pipe and thread of parse_stream, until the thread is joined.
+        TokenPipe *stream = nullptr;
+        std::thread *producer = nullptr;
 };
 
 #endif // PARSER_H
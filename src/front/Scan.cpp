@@ -0,0 +1,70 @@
+#include "Scan.h"
+
+#include "Scan_simd.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+
+namespace {
+
+// SSE2 is part of x86-64, no runtime check is needed.
+struct Sse2 {
+    static constexpr int WIDTH = 16;
+
+    static __m128i load(const char *p) { return _mm_loadu_si128((const __m128i *) p); }
+    static __m128i lower(__m128i v) { return _mm_or_si128(v, _mm_set1_epi8(0x20)); }
+
+    // Used to get the bytes equal to c.
+    static uint32_t eq(__m128i v, char c) {
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+    }
+    // Used to get the bytes inside [lo, lo + len].
+    static uint32_t range(__m128i v, char lo, char len) {
+        auto x = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8(len)), x));
+    }
+};
+
+}
+#endif
+
+const scan::Kernels *scan::scalar_kernels() {
+    static const scan::Kernels table = {
+        .name = "scalar",
+        .skip_blank = Scalar::skip_blank,
+        .line_len = Scalar::line_len,
+        .word_len = Scalar::word_len,
+        .number_len = Scalar::number_len,
+        .field_len = Scalar::field_len,
+    };
+    return &table;
+}
+
+const scan::Kernels *scan::sse2_kernels() {
+#ifdef __SSE2__
+    static const scan::Kernels table = Simd<Sse2>::kernels("sse2");
+    return &table;
+#else
+    return nullptr;
+#endif
+}
+
+#ifndef XTASM_SCAN_AVX2
+// the AVX2 kernels are built only on x86-64 (see CMakeLists.txt).
+const scan::Kernels *scan::avx2_kernels() {
+    return nullptr;
+}
+#endif
+
+const scan::Kernels &scan::kernels() {
+    // selecting the widest implementation supported by the cpu.
+    static const scan::Kernels &selected = [] () -> const scan::Kernels & {
+#if defined(XTASM_SCAN_AVX2) && defined(__GNUC__)
+        if (__builtin_cpu_supports("avx2")) return *scan::avx2_kernels();
+#endif
+        if (scan::sse2_kernels()) return *scan::sse2_kernels();
+        return *scan::scalar_kernels();
+    }();
+
+    return selected;
+}
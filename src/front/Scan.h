@@ -0,0 +1,51 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include "../shared/Basic.h"
+
+// Scanning kernels used by the Lexer to consume runs of characters.
+// Every kernel works on [begin, end) and returns how many bytes the run is long.
+// The implementation (AVX2, SSE2 or scalar) is picked once at runtime.
+namespace scan {
+    // Result of skipping blanks (' ' and '\n').
+    struct Blank {
+        // length of the run.
+        uint_t len;
+        // number of '\n' inside the run.
+        uint_t new_lines;
+        // number of characters after the last '\n' of the run.
+        uint_t tail;
+    };
+
+    // Table of the kernels of a single implementation.
+    struct Kernels {
+        // name of the implementation.
+        const char *name;
+        // run of ' ' and '\n'.
+        Blank (*skip_blank)(const char *begin, const char *end);
+        // run of everything except '\n'.
+        uint_t (*line_len)(const char *begin, const char *end);
+        // run of identifier characters (letters, '_' and '.').
+        uint_t (*word_len)(const char *begin, const char *end);
+        // run of digits and '.'.
+        uint_t (*number_len)(const char *begin, const char *end);
+        // run of everything except ' ' and '\n' (sections, registers, labels).
+        uint_t (*field_len)(const char *begin, const char *end);
+    };
+
+    // Used to get the kernels selected for this machine.
+    const Kernels &kernels();
+
+    // Kernels of every implementation (nullptr if not available on this build).
+    const Kernels *scalar_kernels();
+    const Kernels *sse2_kernels();
+    const Kernels *avx2_kernels();
+
+    inline Blank skip_blank(const char *begin, const char *end) { return kernels().skip_blank(begin, end); }
+    inline uint_t line_len(const char *begin, const char *end) { return kernels().line_len(begin, end); }
+    inline uint_t word_len(const char *begin, const char *end) { return kernels().word_len(begin, end); }
+    inline uint_t number_len(const char *begin, const char *end) { return kernels().number_len(begin, end); }
+    inline uint_t field_len(const char *begin, const char *end) { return kernels().field_len(begin, end); }
+}
+
+#endif // SCAN_H
@@ -0,0 +1,34 @@
+#include "Scan.h"
+
+// This file is compiled with -mavx2 (see CMakeLists.txt), its kernels
+// are used only when the cpu supports them.
+
+#include <immintrin.h>
+
+#include "Scan_simd.h"
+
+namespace {
+
+struct Avx2 {
+    static constexpr int WIDTH = 32;
+
+    static __m256i load(const char *p) { return _mm256_loadu_si256((const __m256i *) p); }
+    static __m256i lower(__m256i v) { return _mm256_or_si256(v, _mm256_set1_epi8(0x20)); }
+
+    // Used to get the bytes equal to c.
+    static uint32_t eq(__m256i v, char c) {
+        return _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c)));
+    }
+    // Used to get the bytes inside [lo, lo + len].
+    static uint32_t range(__m256i v, char lo, char len) {
+        auto x = _mm256_sub_epi8(v, _mm256_set1_epi8(lo));
+        return _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(x, _mm256_set1_epi8(len)), x));
+    }
+};
+
+}
+
+const scan::Kernels *scan::avx2_kernels() {
+    static const scan::Kernels table = Simd<Avx2>::kernels("avx2");
+    return &table;
+}
@@ -0,0 +1,163 @@
+#ifndef SCAN_SIMD_H
+#define SCAN_SIMD_H
+
+// Kernels shared by every implementation of 'Scan.h'.
+// This header is included by one translation unit per instruction set,
+// everything lives in an anonymous namespace so each of them gets its own copy.
+
+#include <cctype>
+#include <cstdint>
+
+#include "Scan.h"
+
+namespace {
+
+// Character classes used by the Lexer.
+inline bool is_blank(char c) { return c == ' ' || c == '\n'; }
+inline bool is_word(char c) { return std::isalpha(c) || c == '_' || c == '.'; }
+inline bool is_number(char c) { return std::isdigit(c) || c == '.'; }
+
+// Bit counts of a mask (never 0). Not the std:: ones, their instances are
+// shared with the file built with -mavx2 and the linker keeps one of them.
+inline uint32_t low_zeros(uint32_t x) { return __builtin_ctz(x); }
+inline uint32_t high_zeros(uint32_t x) { return __builtin_clz(x); }
+inline uint32_t ones(uint32_t x) { return __builtin_popcount(x); }
+
+// Scalar kernels, also used for the tails of the vectorized ones.
+struct Scalar {
+    static scan::Blank skip_blank(const char *begin, const char *end) {
+        scan::Blank blank = { 0, 0, 0 };
+
+        for (auto p = begin; p < end && is_blank(*p); p++) {
+            blank.len++;
+            blank.tail++;
+            if (*p == '\n') {
+                blank.new_lines++;
+                blank.tail = 0;
+            }
+        }
+
+        return blank;
+    }
+
+    static uint_t line_len(const char *begin, const char *end) {
+        auto p = begin;
+        while (p < end && *p != '\n') p++;
+        return p - begin;
+    }
+
+    static uint_t word_len(const char *begin, const char *end) {
+        auto p = begin;
+        while (p < end && is_word(*p)) p++;
+        return p - begin;
+    }
+
+    static uint_t number_len(const char *begin, const char *end) {
+        auto p = begin;
+        while (p < end && is_number(*p)) p++;
+        return p - begin;
+    }
+
+    static uint_t field_len(const char *begin, const char *end) {
+        auto p = begin;
+        while (p < end && !is_blank(*p)) p++;
+        return p - begin;
+    }
+};
+
+// Vectorized kernels.
+// V provides WIDTH, load(), eq() and range(), the masks have one bit per byte.
+template <typename V>
+struct Simd {
+    // every bit of a full mask.
+    static constexpr uint32_t ALL = V::WIDTH == 32 ? 0xffffffffu : (1u << V::WIDTH) - 1;
+
+    // Used to measure a run of bytes inside a class.
+    template <typename In, typename Tail>
+    static uint_t run(const char *begin, const char *end, In in, Tail tail) {
+        auto p = begin;
+
+        while (end - p >= V::WIDTH) {
+            uint32_t stop = ~in(V::load(p)) & ALL;
+            if (stop) return (p - begin) + low_zeros(stop);
+            p += V::WIDTH;
+        }
+
+        return (p - begin) + tail(p, end);
+    }
+
+    static scan::Blank skip_blank(const char *begin, const char *end) {
+        scan::Blank blank = { 0, 0, 0 };
+        auto p = begin;
+        // position of the last '\n' found.
+        const char *last_nl = nullptr;
+
+        while (end - p >= V::WIDTH) {
+            auto v = V::load(p);
+            uint32_t nl = V::eq(v, '\n');
+            uint32_t stop = ~(nl | V::eq(v, ' ')) & ALL;
+
+            // only the '\n' before the end of the run are counted.
+            uint32_t len = stop ? low_zeros(stop) : V::WIDTH;
+            nl &= (uint32_t) ((uint64_t(1) << len) - 1);
+
+            if (nl) {
+                blank.new_lines += ones(nl);
+                last_nl = p + (31 - high_zeros(nl));
+            }
+
+            p += len;
+            if (stop) break;
+        }
+
+        // finishing with the scalar kernel.
+        if (end - p < V::WIDTH) {
+            auto rest = Scalar::skip_blank(p, end);
+            if (rest.new_lines) {
+                blank.new_lines += rest.new_lines;
+                last_nl = p + rest.len - rest.tail - 1;
+            }
+            p += rest.len;
+        }
+
+        blank.len = p - begin;
+        blank.tail = last_nl ? p - last_nl - 1 : blank.len;
+        return blank;
+    }
+
+    static uint_t line_len(const char *begin, const char *end) {
+        return run(begin, end, [](auto v) { return ~V::eq(v, '\n'); }, Scalar::line_len);
+    }
+
+    static uint_t word_len(const char *begin, const char *end) {
+        return run(begin, end, [](auto v) {
+            return V::range(V::lower(v), 'a', 'z' - 'a') | V::eq(v, '_') | V::eq(v, '.');
+        }, Scalar::word_len);
+    }
+
+    static uint_t number_len(const char *begin, const char *end) {
+        return run(begin, end, [](auto v) {
+            return V::range(v, '0', '9' - '0') | V::eq(v, '.');
+        }, Scalar::number_len);
+    }
+
+    static uint_t field_len(const char *begin, const char *end) {
+        return run(begin, end, [](auto v) { return ~(V::eq(v, ' ') | V::eq(v, '\n')); }, Scalar::field_len);
+    }
+
+    // Used to craft the table of the kernels.
+    static scan::Kernels kernels(const char *name) {
+        return (scan::Kernels) {
+            .name = name,
+            .skip_blank = skip_blank,
+            .line_len = line_len,
+            .word_len = word_len,
+            .number_len = number_len,
+            .field_len = field_len,
+        };
+    }
+};
+
+}
+
+#endif // SCAN_SIMD_H
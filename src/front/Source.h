@@ -0,0 +1,45 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <string>
+#include <string_view>
+
+#include "../shared/Basic.h"
+
+// Read-only buffer holding the content of a source file.
+// Regular files are memory-mapped, everything else (pipes, stdin)
+// is read with a single bulk read.
+// The content is always followed by a '\0' sentinel.
+class Source {
+    public:
+        // Default c'tor.
+        explicit Source() = default;
+        // Deleting copy c'tor.
+        explicit Source(const Source &other) = delete;
+        // Destructor.
+        ~Source() { this->close(); }
+
+        // Used to load the content of a file ("-" means stdin).
+        void open(std::string filepath);
+        // Used to release the content.
+        void close();
+
+        // Used to get the loaded content.
+        std::string_view view() const { return std::string_view(this->data, this->size); }
+    private:
+        // Used to map a regular file.
+        bool map(int fd, uint_t file_size);
+        // Used to read everything from a non-mappable fd.
+        void read_all(int fd);
+
+        // pointer to the content.
+        const char *data = "";
+        // length of the content.
+        uint_t size = 0;
+        // length of the mapping (0 if nothing is mapped).
+        uint_t mapped = 0;
+        // fallback buffer for pipes and stdin.
+        std::string buf;
+};
+
+#endif // SOURCE_H
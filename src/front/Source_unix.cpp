@@ -0,0 +1,90 @@
+#include "Source.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+void Source::open(std::string filepath) {
+    // releasing the previous content.
+    this->close();
+
+    int fd = STDIN_FILENO;
+    if (filepath != "-") fd = ::open(filepath.c_str(), O_RDONLY);
+
+    if (fd < 0) {
+        auto msg = "Unable to open '" + filepath + "'. " + std::strerror(errno);
+        crash(msg);
+    }
+
+    // only regular files can be mapped.
+    struct stat st;
+    bool is_file = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+
+    if (!is_file || !this->map(fd, st.st_size)) this->read_all(fd);
+
+    if (fd != STDIN_FILENO) ::close(fd);
+}
+
+void Source::close() {
+    if (this->mapped) munmap((void *) this->data, this->mapped);
+
+    this->buf.clear();
+    this->data = "";
+    this->size = 0;
+    this->mapped = 0;
+}
+
+bool Source::map(int fd, uint_t file_size) {
+    // empty files can't be mapped, the fallback handles them.
+    if (!file_size) return false;
+
+    // reserving one byte more than the file so the sentinel always has
+    // a zero page behind it, even when the size is a multiple of the page.
+    uint_t page = sysconf(_SC_PAGESIZE);
+    uint_t len = (file_size + 1 + page - 1) / page * page;
+
+    void *base = mmap(nullptr, len, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) return false;
+
+    // placing the file over the reserved area.
+    if (mmap(base, file_size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, len);
+        return false;
+    }
+
+    // the whole file is going to be scanned once.
+    madvise(base, len, MADV_SEQUENTIAL);
+
+    this->data = (const char *) base;
+    this->size = file_size;
+    this->mapped = len;
+    return true;
+}
+
+void Source::read_all(int fd) {
+    // growing the buffer geometrically until EOF.
+    uint_t len = 0;
+    this->buf.resize(64 * 1024);
+
+    while (true) {
+        if (len == this->buf.size()) this->buf.resize(this->buf.size() * 2);
+
+        auto n = ::read(fd, this->buf.data() + len, this->buf.size() - len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            auto msg = std::string("Unable to read the source. ") + std::strerror(errno);
+            crash(msg);
+        }
+        if (n == 0) break;
+
+        len += n;
+    }
+
+    // std::string keeps the '\0' sentinel after the content.
+    this->buf.resize(len);
+    this->data = this->buf.data();
+    this->size = len;
+}
@@ -1,6 +1,7 @@
 #include "Token.h"
 
 #include "../shared/Basic.h"
+#include "Files.h"
 
 std::string ttype_str(TokenType type) {
     // handling all the types.
@@ -47,7 +48,7 @@ std::string ttype_str(TokenType type) {
     }
 }
 
-std::string token_loc(Token &tkn) {
+std::string token_loc(const Token &tkn) {
     // calling the helper function with the correct fields.
-    return loc(tkn.file, tkn.line, tkn.column);
+    return loc(File_Table::get_table().path(tkn.file), tkn.line, tkn.column);
 }
@@ -1,7 +1,9 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 #include "../shared/Basic.h"
 
@@ -58,20 +60,22 @@ std::string ttype_str(TokenType type);
 
 // Struct representing a token with its position inside
 // the file system.
+// The text is a view over the source buffer and the file is an id
+// inside the File_Table, so tokens never own heap memory.
 struct Token {
     // type of the token.
     TokenType type;
-    // text of the token.
-    std::string text;
-    // filepath of the token.
-    std::string file;
+    // id of the file of the token (see File_Table).
+    uint32_t file;
     // line where the token is located.
-    uint_t line;
+    uint32_t line;
     // column where the token is located.
-    uint_t column;
+    uint32_t column;
+    // text of the token.
+    std::string_view text;
 };
 
 // Used to craft a stringified location of the token
-std::string token_loc(Token &tkn);
+std::string token_loc(const Token &tkn);
 
 #endif // TOKEN_H
@@ -0,0 +1,57 @@
+#include "TokenPipe.h"
+
+void TokenPipe::push(TokenStream &&batch) {
+    std::unique_lock<std::mutex> guard(this->lock);
+    this->not_full.wait(guard, [this] { return this->count < this->ring.size() || this->aborted; });
+
+    // nobody is left to read it.
+    if (this->aborted) return;
+
+    this->ring[(this->head + this->count) % this->ring.size()] = std::move(batch);
+    this->count++;
+
+    this->not_empty.notify_one();
+}
+
+void TokenPipe::close() {
+    std::unique_lock<std::mutex> guard(this->lock);
+    this->closed = true;
+
+    this->not_empty.notify_all();
+}
+
+void TokenPipe::fail(std::string error) {
+    std::unique_lock<std::mutex> guard(this->lock);
+    this->failure.insert(std::move(error));
+    this->closed = true;
+
+    this->not_empty.notify_all();
+}
+
+void TokenPipe::abort() {
+    std::unique_lock<std::mutex> guard(this->lock);
+    this->aborted = true;
+    this->count = 0;
+
+    this->not_full.notify_all();
+}
+
+bool TokenPipe::pop(TokenStream &batch) {
+    std::unique_lock<std::mutex> guard(this->lock);
+    this->not_empty.wait(guard, [this] { return this->count || this->closed; });
+
+    // closed and drained.
+    if (!this->count) return false;
+
+    batch = std::move(this->ring[this->head]);
+    this->head = (this->head + 1) % this->ring.size();
+    this->count--;
+
+    this->not_full.notify_one();
+    return true;
+}
+
+Option<std::string> TokenPipe::error() {
+    std::unique_lock<std::mutex> guard(this->lock);
+    return this->failure;
+}
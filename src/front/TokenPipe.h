@@ -0,0 +1,54 @@
+#ifndef TOKENPIPE_H
+#define TOKENPIPE_H
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "../shared/Basic.h"
+#include "../shared/Option.h"
+#include "TokenStream.h"
+
+// Bounded ring buffer of token batches.
+// It connects the Lexer (producer) to the Parser (consumer) running on
+// different threads, so only a few batches are alive at the same time.
+class TokenPipe {
+    public:
+        // Used to craft a pipe holding at most capacity batches.
+        explicit TokenPipe(uint_t capacity = 4) : ring(capacity) {}
+        // Deleting copy c'tor.
+        explicit TokenPipe(const TokenPipe &other) = delete;
+
+        // Used to push a batch (blocks while the pipe is full).
+        void push(TokenStream &&batch);
+        // Used to signal that no more batches will be pushed.
+        void close();
+        // Used to close the pipe because the producer stopped on an error.
+        void fail(std::string error);
+        // Used to signal that the consumer stopped, the next batches are dropped.
+        void abort();
+        // Used to pop the next batch (blocks while the pipe is empty).
+        // Returns false once the pipe is closed and drained.
+        bool pop(TokenStream &batch);
+        // Used to get the error the producer stopped on (none if it didn't).
+        Option<std::string> error();
+    private:
+        // slots of the ring buffer.
+        std::vector<TokenStream> ring;
+        // slot of the next batch to pop.
+        uint_t head = 0;
+        // number of batches inside the ring.
+        uint_t count = 0;
+        // no more batches will be pushed.
+        bool closed = false;
+        // no more batches will be popped.
+        bool aborted = false;
+        // error the producer stopped on.
+        Option<std::string> failure = Option<std::string>::none();
+
+        std::mutex lock;
+        std::condition_variable not_full;
+        std::condition_variable not_empty;
+};
+
+#endif // TOKENPIPE_H
@@ -0,0 +1,47 @@
+#include "TokenStream.h"
+
+#include "Files.h"
+
+// the types have to fit the byte array.
+static_assert(TokenType::COUNT <= 256, "ERROR: TokenStream stores the token types as bytes!\n");
+
+TokenStream::TokenStream(uint32_t file) : file(file) {
+    this->base = File_Table::get_table().content(file).data();
+}
+
+void TokenStream::push(const Token &tkn) {
+    // a default crafted stream takes the file of its first token.
+    if (!this->base) *this = TokenStream(tkn.file);
+
+    this->types.push_back(tkn.type);
+    this->offsets.push_back(tkn.text.data() - this->base);
+    this->lengths.push_back(tkn.text.length());
+    this->lines.push_back(tkn.line);
+    this->columns.push_back(tkn.column);
+}
+
+void TokenStream::reserve(uint_t n) {
+    this->types.reserve(n);
+    this->offsets.reserve(n);
+    this->lengths.reserve(n);
+    this->lines.reserve(n);
+    this->columns.reserve(n);
+}
+
+void TokenStream::clear() {
+    this->types.clear();
+    this->offsets.clear();
+    this->lengths.clear();
+    this->lines.clear();
+    this->columns.clear();
+}
+
+Token TokenStream::token(uint_t i) const {
+    return (Token) {
+        .type = this->type(i),
+        .file = this->file,
+        .line = this->lines[i],
+        .column = this->columns[i],
+        .text = std::string_view(this->base + this->offsets[i], this->lengths[i]),
+    };
+}
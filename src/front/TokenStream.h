@@ -0,0 +1,51 @@
+#ifndef TOKENSTREAM_H
+#define TOKENSTREAM_H
+
+#include <cstdint>
+#include <vector>
+
+#include "../shared/Basic.h"
+#include "Token.h"
+
+// Tokens of a single file stored as a structure of arrays.
+// The types are a contiguous byte array, so looking ahead only touches
+// one cache line every 64 tokens. The rest of a token is rebuilt on demand.
+class TokenStream {
+    public:
+        // Default c'tor.
+        explicit TokenStream() = default;
+        // Used to craft an empty stream of tokens coming from a file.
+        explicit TokenStream(uint32_t file);
+
+        // Used to append a token.
+        void push(const Token &tkn);
+        // Used to reserve space for n tokens.
+        void reserve(uint_t n);
+        // Used to remove every token.
+        void clear();
+
+        // Used to get the number of tokens.
+        uint_t size() const { return this->types.size(); }
+        // Used to get the type of a token.
+        TokenType type(uint_t i) const { return (TokenType) this->types[i]; }
+        // Used to rebuild a token.
+        Token token(uint_t i) const;
+    private:
+        // id of the file of the tokens (see File_Table).
+        uint32_t file = 0;
+        // start of the source of the file.
+        const char *base = nullptr;
+
+        // type of every token.
+        std::vector<uint8_t> types;
+        // offset of the text of every token inside the source.
+        std::vector<uint32_t> offsets;
+        // length of the text of every token.
+        std::vector<uint32_t> lengths;
+        // line of every token.
+        std::vector<uint32_t> lines;
+        // column of every token.
+        std::vector<uint32_t> columns;
+};
+
+#endif // TOKENSTREAM_H
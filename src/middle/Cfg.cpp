@@ -0,0 +1,244 @@
+#include "Cfg.h"
+
+#include <utility>
+
+namespace {
+
+// Used to know if an instruction ends its block.
+bool is_terminator(Lir_Op op) {
+    return op == Lir_Op::JMP || op == Lir_Op::BR || op == Lir_Op::EXIT;
+}
+
+}
+
+Cfg::Cfg(const Lir_Program &program) {
+    this->build(program);
+    this->order();
+    this->dominators();
+    this->number_tree();
+    this->find_loops();
+}
+
+void Cfg::build(const Lir_Program &program) {
+    auto &code = program.code;
+    this->label_block.assign(program.labels.size(), NO_BLOCK);
+
+    // a block starts at the beginning, at every label and after every terminator.
+    for (uint32_t i = 0; i < code.size(); i++) {
+        bool leader = i == 0 || code[i].op == Lir_Op::LABEL || is_terminator(code[i - 1].op);
+        // labels in a row share the block.
+        if (leader && i && code[i].op == Lir_Op::LABEL && code[i - 1].op == Lir_Op::LABEL) leader = false;
+
+        if (leader) {
+            if (!this->blocks.empty()) this->blocks.back().end = i;
+            this->blocks.push_back({ i, i, {}, {} });
+        }
+        if (code[i].op == Lir_Op::LABEL) this->label_block[code[i].a.value] = this->blocks.size() - 1;
+    }
+    if (!this->blocks.empty()) this->blocks.back().end = code.size();
+
+    auto link = [&](uint32_t from, uint32_t to) {
+        if (to == NO_BLOCK) crash("Jump to a label that was never placed.\n");
+        this->blocks[from].succs.push_back(to);
+        this->blocks[to].preds.push_back(from);
+    };
+
+    for (uint32_t b = 0; b < this->blocks.size(); b++) {
+        auto &last = code[this->blocks[b].end - 1];
+        bool next = b + 1 < this->blocks.size();
+
+        switch (last.op) {
+            case Lir_Op::JMP:
+                link(b, this->label_block[last.a.value]);
+                break;
+
+            case Lir_Op::BR: {
+                auto target = this->label_block[last.target];
+                link(b, target);
+                if (next && target != b + 1) link(b, b + 1);
+            } break;
+
+            case Lir_Op::EXIT:
+                break;
+
+            default:
+                if (next) link(b, b + 1);
+                break;
+        }
+    }
+}
+
+void Cfg::order() {
+    auto n = this->blocks.size();
+    this->rpo_index.assign(n, NO_BLOCK);
+    if (!n) return;
+
+    // iterative depth first search, every frame is (block, next successor).
+    std::vector<bool> seen(n, false);
+    std::vector<std::pair<uint32_t, uint32_t>> stack;
+    std::vector<uint32_t> post;
+
+    stack.push_back({ 0, 0 });
+    seen[0] = true;
+    while (!stack.empty()) {
+        auto &[block, next] = stack.back();
+        auto &succs = this->blocks[block].succs;
+
+        if (next < succs.size()) {
+            auto succ = succs[next++];
+            if (!seen[succ]) {
+                seen[succ] = true;
+                stack.push_back({ succ, 0 });
+            }
+            continue;
+        }
+
+        post.push_back(block);
+        stack.pop_back();
+    }
+
+    this->rpo.assign(post.rbegin(), post.rend());
+    for (uint32_t i = 0; i < this->rpo.size(); i++) this->rpo_index[this->rpo[i]] = i;
+}
+
+void Cfg::dominators() {
+    this->idom.assign(this->blocks.size(), NO_BLOCK);
+    if (this->rpo.empty()) return;
+
+    auto entry = this->rpo[0];
+    this->idom[entry] = entry;
+
+    // walking up the tree until both fingers meet, the rpo index decreases going up.
+    auto intersect = [&](uint32_t a, uint32_t b) {
+        while (a != b) {
+            while (this->rpo_index[a] > this->rpo_index[b]) a = this->idom[a];
+            while (this->rpo_index[b] > this->rpo_index[a]) b = this->idom[b];
+        }
+        return a;
+    };
+
+    // a couple of passes are enough for the graphs crafted by the lowering.
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        for (uint32_t i = 1; i < this->rpo.size(); i++) {
+            auto block = this->rpo[i];
+            auto dom = NO_BLOCK;
+
+            for (auto pred : this->blocks[block].preds) {
+                if (this->idom[pred] == NO_BLOCK) continue;
+                dom = dom == NO_BLOCK ? pred : intersect(pred, dom);
+            }
+
+            if (this->idom[block] != dom) {
+                this->idom[block] = dom;
+                changed = true;
+            }
+        }
+    }
+}
+
+void Cfg::number_tree() {
+    auto n = this->blocks.size();
+    this->tree_in.assign(n, 0);
+    this->tree_out.assign(n, 0);
+    if (this->rpo.empty()) return;
+
+    // children of every block in the dominator tree, stored contiguously.
+    std::vector<uint32_t> first(n + 1, 0), children(this->rpo.size());
+    for (auto block : this->rpo) {
+        if (block != this->rpo[0]) first[this->idom[block] + 1]++;
+    }
+    for (uint32_t i = 0; i < n; i++) first[i + 1] += first[i];
+    auto next = first;
+    for (auto block : this->rpo) {
+        if (block != this->rpo[0]) children[next[this->idom[block]]++] = block;
+    }
+
+    // iterative depth first search, every frame is (block, next child).
+    std::vector<std::pair<uint32_t, uint32_t>> stack;
+    uint32_t clock = 0;
+
+    stack.push_back({ this->rpo[0], first[this->rpo[0]] });
+    this->tree_in[this->rpo[0]] = clock++;
+    while (!stack.empty()) {
+        auto &[block, child] = stack.back();
+
+        if (child < first[block + 1]) {
+            auto succ = children[child++];
+            this->tree_in[succ] = clock++;
+            stack.push_back({ succ, first[succ] });
+            continue;
+        }
+
+        this->tree_out[block] = clock++;
+        stack.pop_back();
+    }
+}
+
+bool Cfg::dominates(uint32_t a, uint32_t b) const {
+    if (!this->reachable(a) || !this->reachable(b)) return false;
+
+    // the subtree of a is entered before b and left after it.
+    return this->tree_in[a] <= this->tree_in[b] && this->tree_out[b] <= this->tree_out[a];
+}
+
+void Cfg::find_loops() {
+    auto n = this->blocks.size();
+    this->loop_of.assign(n, NO_BLOCK);
+
+    // union-find collapsing every loop found into its header.
+    std::vector<uint32_t> rep(n);
+    for (uint32_t i = 0; i < n; i++) rep[i] = i;
+    auto find = [&](uint32_t block) {
+        auto root = block;
+        while (rep[root] != root) root = rep[root];
+        while (rep[block] != root) block = std::exchange(rep[block], root);
+        return root;
+    };
+
+    // loop headed by every block.
+    std::vector<uint32_t> loop_at(n, NO_BLOCK);
+    std::vector<uint32_t> work;
+
+    // inner headers come later in rpo, going backward finds them first.
+    for (auto i = this->rpo.size(); i-- > 0;) {
+        auto header = this->rpo[i];
+
+        // back edges come from blocks dominated by the header, the other
+        // retreating edges (irreducible flow, from user jumps) make no loop.
+        work.clear();
+        for (auto pred : this->blocks[header].preds) {
+            if (this->dominates(header, pred)) work.push_back(find(pred));
+        }
+        if (work.empty()) continue;
+
+        uint32_t loop = this->loops.size();
+        this->loops.push_back({ header });
+        loop_at[header] = loop;
+        if (this->loop_of[header] == NO_BLOCK) this->loop_of[header] = loop;
+
+        while (!work.empty()) {
+            auto block = work.back();
+            work.pop_back();
+            // already part of this loop.
+            if (block == header || rep[block] != block) continue;
+
+            // the header of an inner loop stands for all of it.
+            if (loop_at[block] != NO_BLOCK) this->loops[loop_at[block]].parent = loop;
+            else this->loop_of[block] = loop;
+            rep[block] = header;
+
+            for (auto pred : this->blocks[block].preds) {
+                if (this->dominates(header, pred)) work.push_back(find(pred));
+            }
+        }
+    }
+
+    // parents come after their children.
+    for (auto i = this->loops.size(); i-- > 0;) {
+        auto parent = this->loops[i].parent;
+        if (parent != NO_BLOCK) this->loops[i].depth = this->loops[parent].depth + 1;
+    }
+}
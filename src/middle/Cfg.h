@@ -0,0 +1,77 @@
+#ifndef CFG_H
+#define CFG_H
+
+#include <cstdint>
+#include <vector>
+
+#include "Lir.h"
+
+// 'Cfg.h' contains the control flow graph of a lowered program, together with
+// its dominator tree and loop nesting forest. Everything is computed in
+// (almost) linear time, the graph is walked without recursion so deep
+// programs can't overflow the stack.
+
+// Used for a missing block or loop.
+inline constexpr uint32_t NO_BLOCK = UINT32_MAX;
+
+// Sequence of instructions entered only from the top and left only from the bottom.
+struct Basic_Block {
+    // range of Lir_Program::code, [first, end).
+    uint32_t first;
+    uint32_t end;
+    std::vector<uint32_t> succs;
+    std::vector<uint32_t> preds;
+};
+
+// Natural loop: the blocks dominated by header that can reach one of its back edges.
+struct Cfg_Loop {
+    uint32_t header;
+    // enclosing loop (NO_BLOCK for the outermost ones).
+    uint32_t parent = NO_BLOCK;
+    // 1 for the outermost loops.
+    uint32_t depth = 1;
+};
+
+class Cfg {
+    public:
+        // Used to build the graph of a program, the entry is block 0.
+        explicit Cfg(const Lir_Program &program);
+
+        std::vector<Basic_Block> blocks;
+        // block starting with every label (NO_BLOCK if never placed).
+        std::vector<uint32_t> label_block;
+        // reachable blocks in reverse post order.
+        std::vector<uint32_t> rpo;
+        // immediate dominator of every block (the entry is its own, NO_BLOCK if unreachable).
+        std::vector<uint32_t> idom;
+        // loops, the inner ones come before the ones containing them.
+        std::vector<Cfg_Loop> loops;
+        // innermost loop of every block (NO_BLOCK outside of any loop).
+        std::vector<uint32_t> loop_of;
+
+        // Used to know if a block can run at all.
+        bool reachable(uint32_t block) const { return this->idom[block] != NO_BLOCK; }
+        // Used to know if every path from the entry to b goes through a.
+        bool dominates(uint32_t a, uint32_t b) const;
+        // Used to get the number of loops around a block.
+        uint32_t depth(uint32_t block) const { return this->loop_of[block] == NO_BLOCK ? 0 : this->loops[this->loop_of[block]].depth; }
+    private:
+        // Used to split the code into blocks and link them.
+        void build(const Lir_Program &program);
+        // Used to number the reachable blocks.
+        void order();
+        // Used to find the immediate dominators (Cooper, Harvey, Kennedy).
+        void dominators();
+        // Used to number the dominator tree, answering dominates() in constant time.
+        void number_tree();
+        // Used to find the loops and how they nest (Havlak, reducible graphs).
+        void find_loops();
+
+        // position of every block inside rpo.
+        std::vector<uint32_t> rpo_index;
+        // time every block is entered and left by a walk of the dominator tree.
+        std::vector<uint32_t> tree_in;
+        std::vector<uint32_t> tree_out;
+};
+
+#endif // CFG_H
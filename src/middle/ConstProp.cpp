@@ -0,0 +1,297 @@
+#include "Cfg.h"
+#include "Opt.h"
+
+namespace {
+
+// Value of a register or variable at some point of the program.
+struct Value {
+    enum Kind : uint8_t {
+        // not reached yet.
+        UNDEF,
+        // always the same known value.
+        CONST,
+        // depends on the path.
+        VARYING,
+    };
+
+    Kind kind = UNDEF;
+    int64_t value = 0;
+
+    bool operator==(const Value &other) const = default;
+};
+
+// Values of every register and variable, registers first.
+using State = std::vector<Value>;
+
+// Past this many values (blocks * locations) only the entry state is known,
+// every other block starts from scratch.
+constexpr uint64_t STATE_BUDGET = 1 << 22;
+
+// Used to combine the values coming from two paths.
+Value meet(const Value &a, const Value &b) {
+    if (a.kind == Value::UNDEF) return b;
+    if (b.kind == Value::UNDEF || a == b) return a;
+    return { Value::VARYING, 0 };
+}
+
+// Used to compute an arithmetic instruction on known values (wrapping like the machine).
+int64_t apply(Lir_Op op, int64_t a, int64_t b) {
+    switch (op) {
+        case Lir_Op::ADD: return (int64_t) ((uint64_t) a + (uint64_t) b);
+        case Lir_Op::SUB: return (int64_t) ((uint64_t) a - (uint64_t) b);
+        case Lir_Op::MUL: return (int64_t) ((uint64_t) a * (uint64_t) b);
+        case Lir_Op::SHL: return (int64_t) ((uint64_t) a << (b & 63));
+        default: return b;
+    }
+}
+
+// Runs the propagation over the graph, then rewrites the program.
+class Propagation {
+    public:
+        explicit Propagation(Lir_Program &program, Opt_Stats &stats) : program(program), stats(stats), cfg(program) {}
+
+        void run();
+    private:
+        // Used to get the position of an operand inside a state (-1 for immediates).
+        int64_t loc(const Operand &op) const;
+        // Used to get the value of an operand.
+        Value eval(const State &state, const Operand &op) const;
+        // Used to apply an instruction to a state.
+        void transfer(const Lir_Instr &instr, State &state) const;
+        // Used to know the outcome of a branch (VARYING if unknown).
+        Value outcome(const Lir_Instr &instr, const State &state) const;
+
+        // Used to get the values at the start of a reached block.
+        State start(uint32_t block) const;
+        // Used to merge a state into the one at the start of a block.
+        void flow(uint32_t block, const State &state);
+        // Used to find the values at the start of every block.
+        void solve();
+        // Used to rewrite the instructions with what is known.
+        void rewrite();
+
+        Lir_Program &program;
+        Opt_Stats &stats;
+        Cfg cfg;
+        // values when the program starts.
+        State entry;
+        // values at the start of every block (only with global).
+        std::vector<State> in;
+        // blocks that can run.
+        std::vector<bool> reached;
+        // blocks whose state changed since they were last visited.
+        std::vector<bool> dirty;
+        // every block is reached with its own state (see STATE_BUDGET).
+        bool global = true;
+};
+
+int64_t Propagation::loc(const Operand &op) const {
+    if (op.kind == Operand_Kind::REG) return op.value;
+    if (op.kind == Operand_Kind::VAR) return REG_COUNT + op.value;
+    return -1;
+}
+
+Value Propagation::eval(const State &state, const Operand &op) const {
+    if (op.kind == Operand_Kind::IMM) return { Value::CONST, op.value };
+
+    auto at = this->loc(op);
+    return at < 0 ? Value { Value::VARYING, 0 } : state[at];
+}
+
+void Propagation::transfer(const Lir_Instr &instr, State &state) const {
+    if (instr.op != Lir_Op::MOV && instr.op != Lir_Op::ADD && instr.op != Lir_Op::SUB && instr.op != Lir_Op::MUL && instr.op != Lir_Op::SHL) return;
+
+    auto &dst = state[this->loc(instr.a)];
+    auto src = this->eval(state, instr.b);
+
+    if (instr.op == Lir_Op::MOV) {
+        dst = src;
+    } else if (dst.kind == Value::CONST && src.kind == Value::CONST) {
+        dst.value = apply(instr.op, dst.value, src.value);
+    } else if (instr.op == Lir_Op::MUL && ((dst.kind == Value::CONST && !dst.value) || (src.kind == Value::CONST && !src.value))) {
+        // anything times zero.
+        dst = { Value::CONST, 0 };
+    } else if (dst.kind != Value::UNDEF && src.kind != Value::UNDEF) {
+        dst = { Value::VARYING, 0 };
+    }
+}
+
+Value Propagation::outcome(const Lir_Instr &instr, const State &state) const {
+    auto a = this->eval(state, instr.a);
+    auto b = this->eval(state, instr.b);
+
+    if (a.kind != Value::CONST || b.kind != Value::CONST) return { Value::VARYING, 0 };
+    return { Value::CONST, compare(instr.cond, a.value, b.value) };
+}
+
+State Propagation::start(uint32_t block) const {
+    if (this->global) return this->in[block];
+
+    // nothing is known past the entry.
+    if (block == 0 && this->cfg.blocks[0].preds.empty()) return this->entry;
+    return State(this->entry.size(), { Value::VARYING, 0 });
+}
+
+void Propagation::flow(uint32_t block, const State &state) {
+    if (!this->reached[block]) {
+        this->reached[block] = true;
+        this->dirty[block] = true;
+        if (this->global) this->in[block] = state;
+        return;
+    }
+
+    if (!this->global) return;
+
+    auto &in = this->in[block];
+    for (uint_t i = 0; i < in.size(); i++) {
+        auto merged = meet(in[i], state[i]);
+        if (merged == in[i]) continue;
+
+        in[i] = merged;
+        this->dirty[block] = true;
+    }
+}
+
+void Propagation::solve() {
+    auto &blocks = this->cfg.blocks;
+    auto &code = this->program.code;
+    uint64_t locs = REG_COUNT + this->program.vars.size();
+
+    this->global = (uint64_t) blocks.size() * locs <= STATE_BUDGET;
+    if (this->global) this->in.assign(blocks.size(), {});
+    this->reached.assign(blocks.size(), false);
+    this->dirty.assign(blocks.size(), false);
+    if (blocks.empty()) return;
+
+    // registers are unknown at the start, variables hold their initial value.
+    this->entry.assign(locs, { Value::VARYING, 0 });
+    for (uint_t i = 0; i < this->program.vars.size(); i++) this->entry[REG_COUNT + i] = { Value::CONST, this->program.vars[i].value };
+    this->flow(0, this->entry);
+
+    // sweeping in reverse post order until nothing changes, every value can only go down twice.
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        for (auto block : this->cfg.rpo) {
+            if (!this->dirty[block]) continue;
+            this->dirty[block] = false;
+            changed = true;
+
+            auto state = this->start(block);
+            for (uint32_t i = blocks[block].first; i < blocks[block].end; i++) this->transfer(code[i], state);
+
+            // following only the edges that can be taken.
+            auto &last = code[blocks[block].end - 1];
+            bool next = block + 1 < blocks.size();
+            switch (last.op) {
+                case Lir_Op::JMP:
+                    this->flow(this->cfg.label_block[last.a.value], state);
+                    break;
+
+                case Lir_Op::BR: {
+                    auto taken = this->outcome(last, state);
+                    if (taken.kind != Value::CONST || taken.value) this->flow(this->cfg.label_block[last.target], state);
+                    if (next && (taken.kind != Value::CONST || !taken.value)) this->flow(block + 1, state);
+                } break;
+
+                case Lir_Op::EXIT:
+                    break;
+
+                default:
+                    if (next) this->flow(block + 1, state);
+                    break;
+            }
+        }
+    }
+}
+
+void Propagation::rewrite() {
+    auto &blocks = this->cfg.blocks;
+    std::vector<Lir_Instr> code;
+    code.reserve(this->program.code.size());
+
+    for (uint32_t block = 0; block < blocks.size(); block++) {
+        auto first = this->program.code.begin() + blocks[block].first;
+        auto end = this->program.code.begin() + blocks[block].end;
+
+        // never reached, left to the dead code elimination.
+        if (!this->reached[block]) {
+            code.insert(code.end(), first, end);
+            continue;
+        }
+
+        auto state = this->start(block);
+        for (auto it = first; it != end; it++) {
+            auto instr = *it;
+            auto known = [&](Operand &op) {
+                auto value = this->eval(state, op);
+                if (op.kind == Operand_Kind::IMM || value.kind != Value::CONST) return;
+
+                op = imm_op(value.value);
+                this->stats.propagated++;
+            };
+
+            switch (instr.op) {
+                case Lir_Op::MOV:
+                    known(instr.b);
+                    break;
+
+                case Lir_Op::ADD:
+                case Lir_Op::SUB:
+                case Lir_Op::MUL:
+                case Lir_Op::SHL: {
+                    auto before = state;
+                    this->transfer(instr, before);
+                    auto result = before[this->loc(instr.a)];
+
+                    if (result.kind == Value::CONST) {
+                        instr = { Lir_Op::MOV, EQU, instr.a, imm_op(result.value), 0 };
+                        this->stats.folded++;
+                    } else {
+                        known(instr.b);
+                    }
+                } break;
+
+                case Lir_Op::BR: {
+                    auto taken = this->outcome(instr, state);
+                    if (taken.kind == Value::CONST) {
+                        this->stats.branches++;
+                        // a false branch just falls through.
+                        if (taken.value) code.push_back({ Lir_Op::JMP, EQU, lbl_op(instr.target), {}, 0 });
+                        continue;
+                    }
+
+                    known(instr.a);
+                    known(instr.b);
+                } break;
+
+                case Lir_Op::EXIT:
+                    known(instr.a);
+                    break;
+
+                default:
+                    break;
+            }
+
+            this->transfer(*it, state);
+            code.push_back(instr);
+        }
+    }
+
+    this->program.code = std::move(code);
+}
+
+void Propagation::run() {
+    this->solve();
+    this->rewrite();
+}
+
+}
+
+void propagate_constants(Lir_Program &program, Opt_Stats &stats) {
+    if (program.code.empty()) return;
+
+    Propagation propagation(program, stats);
+    propagation.run();
+}
@@ -0,0 +1,219 @@
+#include "Cfg.h"
+#include "Opt.h"
+
+namespace {
+
+// Used to know if an instruction writes its first operand.
+bool is_store(const Lir_Instr &instr) {
+    return instr.op == Lir_Op::MOV || instr.op == Lir_Op::ADD || instr.op == Lir_Op::SUB || instr.op == Lir_Op::MUL || instr.op == Lir_Op::SHL;
+}
+
+// Used to get the label reached by a jump or a branch (-1 for the rest).
+int64_t target(const Lir_Instr &instr) {
+    if (instr.op == Lir_Op::JMP) return instr.a.value;
+    if (instr.op == Lir_Op::BR) return instr.target;
+    return -1;
+}
+
+// Removes the code nothing can reach or see.
+class Elimination {
+    public:
+        explicit Elimination(Lir_Program &program, Opt_Stats &stats) : program(program), stats(stats) {}
+
+        void run();
+    private:
+        // Used to drop the blocks the entry can't reach.
+        bool unreachable();
+        // Used to drop the jumps to the instruction right after them.
+        bool jumps();
+        // Used to drop the labels nobody jumps to.
+        bool labels();
+        // Used to drop the writes to registers and variables that are never read.
+        bool stores();
+        // Used to drop the variables left without any use.
+        void vars();
+
+        // Used to drop the marked instructions.
+        void sweep(const std::vector<bool> &dead);
+
+        Lir_Program &program;
+        Opt_Stats &stats;
+};
+
+void Elimination::sweep(const std::vector<bool> &dead) {
+    uint_t kept = 0;
+    for (uint_t i = 0; i < this->program.code.size(); i++) {
+        if (!dead[i]) this->program.code[kept++] = this->program.code[i];
+    }
+    this->program.code.resize(kept);
+}
+
+bool Elimination::unreachable() {
+    Cfg cfg(this->program);
+    std::vector<bool> dead(this->program.code.size(), false);
+    bool changed = false;
+
+    for (uint32_t block = 0; block < cfg.blocks.size(); block++) {
+        if (cfg.reachable(block)) continue;
+
+        for (auto i = cfg.blocks[block].first; i < cfg.blocks[block].end; i++) {
+            dead[i] = true;
+            if (this->program.code[i].op != Lir_Op::LABEL) this->stats.unreachable++;
+        }
+        changed = true;
+    }
+
+    if (changed) this->sweep(dead);
+    return changed;
+}
+
+bool Elimination::jumps() {
+    auto &code = this->program.code;
+    std::vector<bool> dead(code.size(), false);
+    bool changed = false;
+
+    for (uint_t i = 0; i < code.size(); i++) {
+        auto label = target(code[i]);
+        if (label < 0) continue;
+
+        // the labels right after are the next instruction too.
+        for (auto j = i + 1; j < code.size() && code[j].op == Lir_Op::LABEL; j++) {
+            if (code[j].a.value != label) continue;
+
+            // both ways of a branch lead to the same place, comparing has no effect.
+            dead[i] = true;
+            changed = true;
+            this->stats.jumps++;
+            break;
+        }
+    }
+
+    if (changed) this->sweep(dead);
+    return changed;
+}
+
+bool Elimination::labels() {
+    auto &code = this->program.code;
+    std::vector<bool> used(this->program.labels.size(), false);
+    for (auto &instr : code) {
+        auto label = target(instr);
+        if (label >= 0) used[label] = true;
+    }
+
+    std::vector<bool> dead(code.size(), false);
+    bool changed = false;
+    for (uint_t i = 0; i < code.size(); i++) {
+        if (code[i].op != Lir_Op::LABEL || used[code[i].a.value]) continue;
+
+        dead[i] = true;
+        changed = true;
+        this->stats.labels++;
+    }
+
+    if (changed) this->sweep(dead);
+    return changed;
+}
+
+bool Elimination::stores() {
+    auto &code = this->program.code;
+    uint_t locs = REG_COUNT + this->program.vars.size();
+    auto loc = [](const Operand &op) -> int64_t {
+        if (op.kind == Operand_Kind::REG) return op.value;
+        if (op.kind == Operand_Kind::VAR) return REG_COUNT + op.value;
+        return -1;
+    };
+
+    // reads of every location, a store reading its own destination doesn't count.
+    std::vector<uint_t> reads(locs, 0);
+    std::vector<std::vector<uint32_t>> writers(locs);
+    for (uint32_t i = 0; i < code.size(); i++) {
+        auto &instr = code[i];
+        auto a = loc(instr.a), b = loc(instr.b);
+
+        if (is_store(instr)) {
+            writers[a].push_back(i);
+            if (b >= 0 && b != a) reads[b]++;
+        } else {
+            if (a >= 0) reads[a]++;
+            if (b >= 0) reads[b]++;
+        }
+    }
+
+    // dropping a store can leave its source unread in turn.
+    std::vector<int64_t> work;
+    for (uint_t l = 0; l < locs; l++) {
+        if (!reads[l] && !writers[l].empty()) work.push_back(l);
+    }
+
+    std::vector<bool> dead(code.size(), false);
+    bool changed = false;
+    while (!work.empty()) {
+        auto l = work.back();
+        work.pop_back();
+
+        for (auto i : writers[l]) {
+            dead[i] = true;
+            changed = true;
+            this->stats.stores++;
+
+            auto b = loc(code[i].b);
+            if (b >= 0 && b != l && !--reads[b] && !writers[b].empty()) work.push_back(b);
+        }
+        writers[l].clear();
+    }
+
+    if (changed) this->sweep(dead);
+    return changed;
+}
+
+void Elimination::vars() {
+    auto &vars = this->program.vars;
+    std::vector<bool> used(vars.size(), false);
+    for (auto &instr : this->program.code) {
+        if (instr.a.kind == Operand_Kind::VAR) used[instr.a.value] = true;
+        if (instr.b.kind == Operand_Kind::VAR) used[instr.b.value] = true;
+    }
+
+    // new index of every variable kept.
+    std::vector<int64_t> index(vars.size(), -1);
+    uint_t kept = 0;
+    for (uint_t i = 0; i < vars.size(); i++) {
+        if (!used[i]) {
+            this->stats.vars++;
+            continue;
+        }
+
+        index[i] = kept;
+        if (kept != i) vars[kept] = std::move(vars[i]);
+        kept++;
+    }
+    if (kept == vars.size()) return;
+    vars.resize(kept);
+
+    for (auto &instr : this->program.code) {
+        if (instr.a.kind == Operand_Kind::VAR) instr.a.value = index[instr.a.value];
+        if (instr.b.kind == Operand_Kind::VAR) instr.b.value = index[instr.b.value];
+    }
+}
+
+void Elimination::run() {
+    // every removal can expose more, a handful of rounds is enough in practice.
+    bool changed = true;
+    while (changed) {
+        changed = this->unreachable();
+        changed |= this->jumps();
+        changed |= this->labels();
+        changed |= this->stores();
+    }
+
+    this->vars();
+}
+
+}
+
+void eliminate_dead_code(Lir_Program &program, Opt_Stats &stats) {
+    if (program.code.empty()) return;
+
+    Elimination elimination(program, stats);
+    elimination.run();
+}
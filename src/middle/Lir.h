@@ -0,0 +1,142 @@
+#ifndef LIR_H
+#define LIR_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../InstructionSet.h"
+#include "../shared/Basic.h"
+
+// 'Lir.h' contains the lowered representation of a program: a linear list
+// of simple instructions where every structured instruction (if, loops,
+// conditions) is already turned into labels and branches.
+// It's what the native backends and the analysis passes work on.
+
+// Operations of the lowered instructions.
+enum class Lir_Op : uint8_t {
+    // a: label.
+    LABEL,
+    // a = b.
+    MOV,
+    // a += b.
+    ADD,
+    // a -= b.
+    SUB,
+    // a *= b.
+    MUL,
+    // a <<= b (an immediate below 64), only crafted by the peephole rules.
+    SHL,
+    // goto a (label).
+    JMP,
+    // if (a cond b) goto target.
+    BR,
+    // terminates the program with a.
+    EXIT,
+};
+
+// Number of operations.
+inline constexpr uint_t LIR_OP_COUNT = (uint_t) Lir_Op::EXIT + 1;
+
+// Kinds of operand.
+enum class Operand_Kind : uint8_t {
+    NONE,
+    // machine register (see REG_NAMES).
+    REG,
+    // variable of the program (index of Lir_Program::vars).
+    VAR,
+    // immediate value.
+    IMM,
+    // label (index of Lir_Program::labels).
+    LBL,
+};
+
+struct Operand {
+    Operand_Kind kind = Operand_Kind::NONE;
+    int64_t value = 0;
+
+    bool operator==(const Operand &other) const = default;
+};
+
+// Used to craft operands.
+inline Operand reg_op(int64_t reg) { return { Operand_Kind::REG, reg }; }
+inline Operand var_op(int64_t var) { return { Operand_Kind::VAR, var }; }
+inline Operand imm_op(int64_t value) { return { Operand_Kind::IMM, value }; }
+inline Operand lbl_op(int64_t label) { return { Operand_Kind::LBL, label }; }
+
+struct Lir_Instr {
+    Lir_Op op;
+    // comparison of a BR.
+    Cond_Op cond = EQU;
+    Operand a;
+    Operand b;
+    // label reached by a BR.
+    uint32_t target = 0;
+};
+
+// Variable living in memory.
+struct Lir_Var {
+    std::string name;
+    // initial value.
+    int64_t value;
+    // declared with '?' (or crafted by the compiler), no initial value.
+    bool bss;
+};
+
+struct Lir_Label {
+    std::string name;
+    // written by the user (':name'), otherwise crafted while lowering.
+    bool user;
+};
+
+struct Lir_Program {
+    std::vector<Lir_Var> vars;
+    std::vector<Lir_Label> labels;
+    std::vector<Lir_Instr> code;
+};
+
+// Number of machine registers an operand can name.
+inline constexpr uint_t REG_COUNT = 16;
+
+// Names of the registers, numbered like the x86-64 encoding.
+inline constexpr std::string_view REG_NAMES[REG_COUNT] = {
+    "rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+    "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15",
+};
+
+// Register reserved by the backends as scratch, programs can't name it.
+inline constexpr int64_t REG_SCRATCH = 11;
+
+// Used to get the opposite comparison.
+inline Cond_Op negate(Cond_Op cond) {
+    switch (cond) {
+        case EQU: return NEQU;
+        case NEQU: return EQU;
+        case LTH: return GTE;
+        case LTE: return GT;
+        case GT: return LTE;
+        case GTE: return LTH;
+    }
+
+    return cond;
+}
+
+// Used to evaluate a comparison between known values.
+inline bool compare(Cond_Op cond, int64_t lhs, int64_t rhs) {
+    switch (cond) {
+        case EQU: return lhs == rhs;
+        case NEQU: return lhs != rhs;
+        case LTH: return lhs < rhs;
+        case LTE: return lhs <= rhs;
+        case GT: return lhs > rhs;
+        case GTE: return lhs >= rhs;
+    }
+
+    return false;
+}
+
+// Used to turn the syntax tree into its lowered form.
+Lir_Program lower(const Instrs &instructions);
+
+#endif // LIR_H
@@ -0,0 +1,50 @@
+#include "Liveness.h"
+
+namespace {
+
+// Past this many bits (blocks * locations) the sets are not computed.
+constexpr uint64_t LIVENESS_BUDGET = 1ull << 28;
+
+}
+
+bool Liveness::affordable(const Lir_Program &program, const Cfg &cfg) {
+    return (uint64_t) cfg.blocks.size() * (REG_COUNT + program.vars.size()) <= LIVENESS_BUDGET;
+}
+
+Liveness::Liveness(const Lir_Program &program, const Cfg &cfg) {
+    auto &blocks = cfg.blocks;
+    auto &code = program.code;
+    auto locs = REG_COUNT + program.vars.size();
+
+    // read before being written (gen) and written (kill) inside every block.
+    std::vector<Loc_Set> gen(blocks.size(), Loc_Set(locs)), kill(blocks.size(), Loc_Set(locs));
+    for (uint32_t b = 0; b < blocks.size(); b++) {
+        for (auto i = blocks[b].first; i < blocks[b].end; i++) {
+            locations(code[i], [&](uint_t loc, bool is_def) {
+                if (is_def) kill[b].add(loc);
+                else if (!kill[b].has(loc)) gen[b].add(loc);
+            });
+        }
+    }
+
+    this->live_in.assign(blocks.size(), Loc_Set(locs));
+    this->live_out.assign(blocks.size(), Loc_Set(locs));
+
+    // backward problem, post order converges in a few sweeps.
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        for (auto it = cfg.rpo.rbegin(); it != cfg.rpo.rend(); it++) {
+            auto b = *it;
+            for (auto succ : blocks[b].succs) this->live_out[b].merge(this->live_in[succ]);
+
+            // in = gen | (out - kill).
+            Loc_Set in = gen[b];
+            this->live_out[b].each([&](uint_t loc) {
+                if (!kill[b].has(loc)) in.add(loc);
+            });
+            changed |= this->live_in[b].merge(in);
+        }
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef LIVENESS_H
+#define LIVENESS_H
+
+#include <cstdint>
+#include <vector>
+
+#include "Cfg.h"
+#include "Lir.h"
+
+// 'Liveness.h' contains the registers and variables (locations) whose value
+// can still be read at the start and at the end of every block.
+// Registers come first, variable v is location REG_COUNT + v.
+
+// Set of locations.
+class Loc_Set {
+    public:
+        explicit Loc_Set(uint_t size = 0) : words((size + 63) / 64, 0) {}
+
+        bool has(uint_t loc) const { return this->words[loc / 64] >> (loc % 64) & 1; }
+        void add(uint_t loc) { this->words[loc / 64] |= 1ull << (loc % 64); }
+
+        // Used to add every location of other, true if something was added.
+        bool merge(const Loc_Set &other) {
+            bool changed = false;
+            for (uint_t i = 0; i < this->words.size(); i++) {
+                auto merged = this->words[i] | other.words[i];
+                changed |= merged != this->words[i];
+                this->words[i] = merged;
+            }
+            return changed;
+        }
+
+        // Used to visit every location of the set.
+        template <typename F>
+        void each(F f) const {
+            for (uint_t i = 0; i < this->words.size(); i++) {
+                for (auto word = this->words[i]; word; word &= word - 1) f(i * 64 + __builtin_ctzll(word));
+            }
+        }
+    private:
+        std::vector<uint64_t> words;
+};
+
+// Used to get the location of an operand (-1 for immediates and labels).
+inline int64_t location(const Operand &op) {
+    if (op.kind == Operand_Kind::REG) return op.value;
+    if (op.kind == Operand_Kind::VAR) return REG_COUNT + op.value;
+    return -1;
+}
+
+// Used to call f(loc, is_def) on the locations an instruction reads and writes, reads first.
+template <typename F>
+void locations(const Lir_Instr &instr, F f) {
+    auto use = [&](const Operand &op) {
+        auto loc = location(op);
+        if (loc >= 0) f(loc, false);
+    };
+
+    switch (instr.op) {
+        case Lir_Op::MOV:
+            use(instr.b);
+            f(location(instr.a), true);
+            break;
+
+        case Lir_Op::ADD:
+        case Lir_Op::SUB:
+        case Lir_Op::MUL:
+        case Lir_Op::SHL:
+            use(instr.a);
+            use(instr.b);
+            f(location(instr.a), true);
+            break;
+
+        case Lir_Op::BR:
+            use(instr.a);
+            use(instr.b);
+            break;
+
+        case Lir_Op::EXIT:
+            use(instr.a);
+            break;
+
+        default:
+            break;
+    }
+}
+
+class Liveness {
+    public:
+        // Used to solve the liveness of a program over its graph.
+        explicit Liveness(const Lir_Program &program, const Cfg &cfg);
+
+        // Used to know if the sets fit the memory budget (blocks * locations bits).
+        static bool affordable(const Lir_Program &program, const Cfg &cfg);
+
+        // locations read before being written from the start of every block.
+        std::vector<Loc_Set> live_in;
+        // locations read before being written from the end of every block.
+        std::vector<Loc_Set> live_out;
+};
+
+#endif // LIVENESS_H
@@ -0,0 +1,290 @@
+#include <optional>
+#include <span>
+
+#include "Cfg.h"
+#include "Liveness.h"
+#include "Opt.h"
+
+namespace {
+
+// Rounds of the pass, every round can free the moves depending on the ones just hoisted.
+constexpr uint32_t MAX_ROUNDS = 8;
+
+// Instructions looked at per round, loops nested deep (jumps to labels) repeat the same code.
+constexpr uint64_t LOOP_BUDGET = 1ull << 24;
+
+// Moves the invariant code out of the loops and turns the multiplications of
+// their counters into additions.
+class Loop_Opt {
+    public:
+        explicit Loop_Opt(Lir_Program &program, Opt_Stats &stats) : program(program), stats(stats) {}
+
+        // Used to transform every loop once, false if nothing changed.
+        bool round();
+    private:
+        // Used to lay out the blocks so that every loop is a range of them.
+        void members();
+        // Used to get the blocks inside a loop.
+        std::span<const uint32_t> inside(uint32_t loop) const;
+        // Used to find the position of the code running right before the loop (NO_BLOCK if none).
+        uint32_t preheader(uint32_t loop) const;
+        // Used to transform a loop, false if nothing changed.
+        bool transform(uint32_t loop, uint32_t at);
+        // Used to know if the pair MOV t, i; MUL t, C at pos can be replaced by additions.
+        bool reducible(uint32_t loop, uint32_t block, uint32_t pos) const;
+        // Used to write the changes into the program.
+        void rebuild();
+
+        Lir_Program &program;
+        Opt_Stats &stats;
+        std::optional<Cfg> cfg;
+        std::optional<Liveness> live;
+
+        // blocks inside loops, the ones of every loop next to each other.
+        std::vector<uint32_t> order;
+        // range of order of every loop.
+        std::vector<std::pair<uint32_t, uint32_t>> spans;
+        // instructions before every position of order.
+        std::vector<uint64_t> sizes;
+        // instructions looked at by this round.
+        uint64_t work = 0;
+
+        // writes inside the current loop, per location.
+        std::vector<uint32_t> defs;
+        // writes adding or subtracting an immediate, per location.
+        std::vector<uint32_t> steps;
+        // loops holding a loop changed by this round.
+        std::vector<bool> dirty;
+        // instructions dropped, instructions added before every position.
+        std::vector<bool> dropped;
+        std::vector<std::vector<Lir_Instr>> added;
+};
+
+// Used to know if an instruction moves a location by a known amount.
+bool is_step(const Lir_Instr &instr) {
+    return (instr.op == Lir_Op::ADD || instr.op == Lir_Op::SUB) && instr.b.kind == Operand_Kind::IMM;
+}
+
+void Loop_Opt::members() {
+    auto &cfg = *this->cfg;
+    auto count = cfg.loops.size();
+
+    // blocks whose innermost loop is the loop, loops right inside it.
+    std::vector<std::vector<uint32_t>> own(count), children(count);
+    for (uint32_t b = 0; b < cfg.blocks.size(); b++) {
+        if (cfg.loop_of[b] != NO_BLOCK) own[cfg.loop_of[b]].push_back(b);
+    }
+    for (uint32_t loop = 0; loop < count; loop++) {
+        if (cfg.loops[loop].parent != NO_BLOCK) children[cfg.loops[loop].parent].push_back(loop);
+    }
+
+    this->order.clear();
+    this->spans.assign(count, { 0, 0 });
+
+    // walking the loop forest, a loop ends after the loops inside it.
+    std::vector<std::pair<uint32_t, uint32_t>> stack;
+    for (uint32_t root = 0; root < count; root++) {
+        if (cfg.loops[root].parent != NO_BLOCK) continue;
+
+        stack.push_back({ root, 0 });
+        this->spans[root].first = this->order.size();
+        this->order.insert(this->order.end(), own[root].begin(), own[root].end());
+
+        while (!stack.empty()) {
+            auto &[loop, next] = stack.back();
+            if (next == children[loop].size()) {
+                this->spans[loop].second = this->order.size();
+                stack.pop_back();
+                continue;
+            }
+
+            auto child = children[loop][next++];
+            this->spans[child].first = this->order.size();
+            this->order.insert(this->order.end(), own[child].begin(), own[child].end());
+            stack.push_back({ child, 0 });
+        }
+    }
+
+    this->sizes.assign(this->order.size() + 1, 0);
+    for (uint32_t k = 0; k < this->order.size(); k++) {
+        auto &block = cfg.blocks[this->order[k]];
+        this->sizes[k + 1] = this->sizes[k] + block.end - block.first;
+    }
+}
+
+std::span<const uint32_t> Loop_Opt::inside(uint32_t loop) const {
+    auto [first, end] = this->spans[loop];
+    return { this->order.data() + first, end - first };
+}
+
+uint32_t Loop_Opt::preheader(uint32_t loop) const {
+    auto &cfg = *this->cfg;
+    auto header = cfg.loops[loop].header;
+
+    // a single way in, from a block going nowhere else.
+    uint32_t outside = NO_BLOCK;
+    for (auto pred : cfg.blocks[header].preds) {
+        if (!cfg.reachable(pred) || cfg.dominates(header, pred)) continue;
+        if (outside != NO_BLOCK) return NO_BLOCK;
+        outside = pred;
+    }
+    if (outside == NO_BLOCK || cfg.blocks[outside].succs.size() != 1) return NO_BLOCK;
+
+    auto &block = cfg.blocks[outside];
+    auto last = this->program.code[block.end - 1].op;
+    if (last == Lir_Op::JMP) return block.end - 1;
+    if (last == Lir_Op::BR || block.end != cfg.blocks[header].first) return NO_BLOCK;
+
+    // falling through, right before the label of the header.
+    return block.end;
+}
+
+bool Loop_Opt::reducible(uint32_t loop, uint32_t block, uint32_t pos) const {
+    auto &code = this->program.code;
+    auto &mov = code[pos];
+    auto &mul = code[pos + 1];
+
+    if (mov.op != Lir_Op::MOV || mul.op != Lir_Op::MUL || mul.a != mov.a || mul.b.kind != Operand_Kind::IMM) return false;
+    auto t = location(mov.a), i = location(mov.b);
+
+    // i only moves by known steps, t only by the pair.
+    if (i < 0 || t == i || this->defs[t] != 2 || !this->defs[i] || this->defs[i] != this->steps[i]) return false;
+
+    // t has to hold i * C from the pair on, ending with the block.
+    auto header = this->cfg->loops[loop].header;
+    if (this->live->live_in[header].has(t) || this->live->live_out[block].has(t)) return false;
+
+    // the reads of t can't see i move.
+    bool moved = false;
+    for (auto k = pos + 2; k < this->cfg->blocks[block].end; k++) {
+        bool read = false;
+        locations(code[k], [&](uint_t loc, bool is_def) { read |= !is_def && (int64_t) loc == t; });
+        if (read && moved) return false;
+
+        moved |= location(code[k].a) == i && is_step(code[k]);
+    }
+
+    return true;
+}
+
+bool Loop_Opt::transform(uint32_t loop, uint32_t at) {
+    auto &code = this->program.code;
+    auto &cfg = *this->cfg;
+    auto header = cfg.loops[loop].header;
+    auto blocks = this->inside(loop);
+    bool changed = false;
+
+    for (auto b : blocks) {
+        for (auto k = cfg.blocks[b].first; k < cfg.blocks[b].end; k++) {
+            locations(code[k], [&](uint_t loc, bool is_def) {
+                if (!is_def) return;
+                this->defs[loc]++;
+                if (is_step(code[k])) this->steps[loc]++;
+            });
+        }
+    }
+
+    for (auto b : blocks) {
+        auto &range = cfg.blocks[b];
+        for (auto k = range.first; k < range.end; k++) {
+            auto &instr = code[k];
+            if (instr.op != Lir_Op::MOV || this->dropped[k]) continue;
+
+            auto x = location(instr.a), v = location(instr.b);
+
+            // x = v on every iteration, with nothing reading x before the move.
+            if (this->defs[x] == 1 && (v < 0 || !this->defs[v]) && !this->live->live_in[header].has(x)) {
+                this->added[at].push_back(instr);
+                this->dropped[k] = true;
+                this->stats.hoisted++;
+                changed = true;
+                continue;
+            }
+
+            if (k + 1 >= range.end || this->work > LOOP_BUDGET || !this->reducible(loop, b, k)) continue;
+
+            // t = i * C stays true if t moves along with i.
+            auto c = code[k + 1].b.value;
+            for (auto l : blocks) {
+                for (auto m = cfg.blocks[l].first; m < cfg.blocks[l].end; m++) {
+                    if (location(code[m].a) != v || !is_step(code[m])) continue;
+                    auto step = (int64_t) ((uint64_t) code[m].b.value * (uint64_t) c);
+                    this->added[m + 1].push_back({ code[m].op, EQU, instr.a, imm_op(step), 0 });
+                }
+            }
+            this->work += this->sizes[this->spans[loop].second] - this->sizes[this->spans[loop].first];
+
+            this->added[at].push_back(instr);
+            this->added[at].push_back(code[k + 1]);
+            this->dropped[k] = this->dropped[k + 1] = true;
+            this->stats.reduced++;
+            changed = true;
+        }
+    }
+
+    for (auto b : blocks) {
+        for (auto k = cfg.blocks[b].first; k < cfg.blocks[b].end; k++) {
+            locations(code[k], [&](uint_t loc, bool is_def) { this->defs[loc] = this->steps[loc] = 0; });
+        }
+    }
+
+    return changed;
+}
+
+void Loop_Opt::rebuild() {
+    auto &code = this->program.code;
+
+    std::vector<Lir_Instr> rebuilt;
+    rebuilt.reserve(code.size());
+    for (uint_t i = 0; i <= code.size(); i++) {
+        rebuilt.insert(rebuilt.end(), this->added[i].begin(), this->added[i].end());
+        if (i < code.size() && !this->dropped[i]) rebuilt.push_back(code[i]);
+    }
+
+    code = std::move(rebuilt);
+}
+
+bool Loop_Opt::round() {
+    this->cfg.emplace(this->program);
+    auto &loops = this->cfg->loops;
+    if (loops.empty() || !Liveness::affordable(this->program, *this->cfg)) return false;
+
+    this->live.emplace(this->program, *this->cfg);
+    this->members();
+
+    auto &code = this->program.code;
+    this->work = 0;
+    this->defs.assign(REG_COUNT + this->program.vars.size(), 0);
+    this->steps.assign(this->defs.size(), 0);
+    this->dirty.assign(loops.size(), false);
+    this->dropped.assign(code.size(), false);
+    this->added.assign(code.size() + 1, {});
+
+    bool changed = false;
+    // inner loops first, the loops around a changed one wait for the next round.
+    for (uint32_t loop = 0; loop < loops.size(); loop++) {
+        auto size = this->sizes[this->spans[loop].second] - this->sizes[this->spans[loop].first];
+        if (this->dirty[loop] || this->work + size > LOOP_BUDGET) continue;
+
+        auto at = this->preheader(loop);
+        if (at == NO_BLOCK) continue;
+
+        this->work += size;
+        if (!this->transform(loop, at)) continue;
+
+        for (auto parent = loops[loop].parent; parent != NO_BLOCK && !this->dirty[parent]; parent = loops[parent].parent) this->dirty[parent] = true;
+        changed = true;
+    }
+
+    if (changed) this->rebuild();
+    return changed;
+}
+
+}
+
+void optimize_loops(Lir_Program &program, Opt_Stats &stats) {
+    if (program.code.empty()) return;
+
+    Loop_Opt loops(program, stats);
+    for (uint32_t i = 0; i < MAX_ROUNDS && loops.round(); i++) {}
+}
@@ -0,0 +1,475 @@
+#include "Lir.h"
+#include "Opt.h"
+
+#include <cctype>
+#include <charconv>
+#include <unordered_map>
+
+namespace {
+
+// Used to parse an integer literal.
+int64_t parse_int(std::string_view text) {
+    int64_t value = 0;
+    auto [end, err] = std::from_chars(text.data(), text.data() + text.length(), value);
+
+    if (err != std::errc() || end != text.data() + text.length()) {
+        crash("Invalid integer '" + std::string(text) + "'\n");
+    }
+
+    return value;
+}
+
+// Used to get the number of a register from its name ("AX", "rax", "R8", ...).
+int64_t parse_reg(std::string_view text) {
+    std::string name;
+    for (auto c : text) name += std::tolower(c);
+
+    // the legacy names are accepted with or without the 'e'/'r' prefix.
+    static const std::string_view LEGACY[8] = { "ax", "cx", "dx", "bx", "sp", "bp", "si", "di" };
+
+    int64_t reg = -1;
+    for (int64_t i = 0; i < 8; i++) {
+        if (name == LEGACY[i] || name == "e" + std::string(LEGACY[i]) || name == "r" + std::string(LEGACY[i])) reg = i;
+    }
+    for (int64_t i = 8; i < (int64_t) REG_COUNT; i++) {
+        if (name == REG_NAMES[i]) reg = i;
+    }
+
+    if (reg < 0) crash("Unknown register '$" + std::string(text) + "'\n");
+
+    // the stack is used by the program itself, r11 by the backends.
+    if (reg == 4 || reg == 5 || reg == REG_SCRATCH) {
+        crash("Register '$" + std::string(text) + "' is reserved\n");
+    }
+
+    return reg;
+}
+
+// Measures the body of a loop before copying it.
+class Body_Size final : public Const_Visitor {
+    public:
+        // statements, the nested ones included.
+        uint_t statements = 0;
+        // the body places labels, a copy would place them twice.
+        bool labels = false;
+        // the body holds a loop, only the innermost loops are copied.
+        bool loops = false;
+
+        void visit_label(std::string_view name) { this->labels = true; }
+        void visit_exit(const Instr &value) { this->statements++; }
+        void visit_add(const Instr &dst, const Instr &src) { this->statements++; }
+        void visit_sub(const Instr &dst, const Instr &src) { this->statements++; }
+        void visit_mul(const Instr &dst, const Instr &src) { this->statements++; }
+        void visit_mov(const Instr &dst, const Instr &src) { this->statements++; }
+        void visit_jmp(const Instr &target) { this->statements++; }
+        void visit_break() { this->statements++; }
+        void visit_while(Instrs_View conditions, std::span<const Bool_Op> bool_ops, Instrs_View body) { this->loops = true; }
+        void visit_for(const Instr &range_left, const Instr &range_right, const Instr &increment, Instrs_View body) { this->loops = true; }
+        void visit_loop(Instrs_View body) { this->loops = true; }
+        void visit_if(Instrs_View conditions, std::span<const Bool_Op> bool_ops, Instrs_View if_body, Instrs_View else_body) {
+            this->statements += conditions.size();
+            this->visit(if_body);
+            this->visit(else_body);
+        }
+};
+
+// Lowers the syntax tree while visiting it.
+class Lowering final : public Const_Visitor {
+    public:
+        // the lowered program.
+        Lir_Program program;
+
+        // Used to check what's left once everything is visited.
+        void finish();
+
+        void visit_data(Instrs_View variables);
+        void visit_code(Instrs_View instructions);
+        void visit_label(std::string_view name);
+        void visit_exit(const Instr &value);
+        void visit_add(const Instr &dst, const Instr &src) { this->emit(Lir_Op::ADD, this->dest(dst), this->operand(src)); }
+        void visit_sub(const Instr &dst, const Instr &src) { this->emit(Lir_Op::SUB, this->dest(dst), this->operand(src)); }
+        void visit_mul(const Instr &dst, const Instr &src) { this->emit(Lir_Op::MUL, this->dest(dst), this->operand(src)); }
+        void visit_mov(const Instr &dst, const Instr &src) { this->emit(Lir_Op::MOV, this->dest(dst), this->operand(src)); }
+        void visit_jmp(const Instr &target);
+        void visit_break();
+        void visit_enum(std::string_view name, Instrs_View values);
+        void visit_while(Instrs_View conditions, std::span<const Bool_Op> bool_ops, Instrs_View body);
+        void visit_for(const Instr &range_left, const Instr &range_right, const Instr &increment, Instrs_View body);
+        void visit_loop(Instrs_View body);
+        void visit_if(Instrs_View conditions, std::span<const Bool_Op> bool_ops, Instrs_View if_body, Instrs_View else_body);
+        void visit_cond(Cond_Op op, const Instr &lhs, const Instr &rhs);
+        void visit_var(std::string_view name, std::string_view value, bool is_decl);
+    private:
+        // Used to append an instruction.
+        void emit(Lir_Op op, Operand a = {}, Operand b = {}) { this->program.code.push_back({ op, EQU, a, b, 0 }); }
+        // Used to append a label.
+        void place(uint32_t label) { this->emit(Lir_Op::LABEL, lbl_op(label)); }
+
+        // Used to get the label written by the user with this name.
+        uint32_t label(std::string_view name);
+        // Used to craft a new label.
+        uint32_t fresh(std::string name);
+
+        // Used to lower a value (variable, constant, register or integer).
+        Operand operand(const Instr &instr);
+        // Used to lower a value that has to be written.
+        Operand dest(const Instr &instr);
+
+        // Used to lay out the copies of the body of a counted loop, see visit_for.
+        void unroll(const std::string &id, const Operand &left, const Operand &right, const Operand &step, Instrs_View body);
+
+        // Used to lower a chain of conditions joined by bool operators.
+        // Jumps to on_true or on_false, next is the label placed right after the chain.
+        void branch(Instrs_View conditions, std::span<const Bool_Op> bool_ops, uint32_t on_true, uint32_t on_false, uint32_t next);
+
+        // variables by name.
+        std::unordered_map<std::string, uint32_t> vars;
+        // enum constants by name.
+        std::unordered_map<std::string, int64_t> constants;
+        // user labels by name.
+        std::unordered_map<std::string, uint32_t> labels;
+        // labels already placed.
+        std::vector<bool> placed;
+        // end labels of the enclosing loops.
+        std::vector<uint32_t> loops;
+        // counter used to name the crafted labels and variables.
+        uint_t counter = 0;
+};
+
+void Lowering::visit_data(Instrs_View variables) {
+    // only declarations and enums can be found here.
+    this->visit(variables);
+}
+
+void Lowering::visit_var(std::string_view name, std::string_view value, bool is_decl) {
+    // references are lowered by operand().
+    if (!is_decl) crash("Unexpected variable '" + std::string(name) + "' outside of an instruction\n");
+
+    std::string key(name);
+    if (this->vars.contains(key) || this->constants.contains(key)) crash("Variable '." + key + "' declared twice\n");
+
+    bool bss = value == "?";
+    this->vars.emplace(key, this->program.vars.size());
+    this->program.vars.push_back({ key, bss ? 0 : parse_int(value), bss });
+}
+
+void Lowering::visit_enum(std::string_view name, Instrs_View values) {
+    // the members are named like 'enum_name.member' and become constants.
+    for (auto &value : values) {
+        auto var = (const Var *) value.get();
+        std::string key(var->name);
+        if (this->vars.contains(key) || this->constants.contains(key)) crash("Variable '." + key + "' declared twice\n");
+
+        this->constants.emplace(key, parse_int(var->value));
+    }
+}
+
+void Lowering::visit_code(Instrs_View instructions) {
+    this->visit(instructions);
+    // falling off the end of the code means success.
+    this->emit(Lir_Op::EXIT, imm_op(0));
+}
+
+void Lowering::visit_label(std::string_view name) {
+    auto label = this->label(name);
+    if (this->placed[label]) crash("Label ':" + std::string(name) + "' declared twice\n");
+
+    this->placed[label] = true;
+    this->place(label);
+}
+
+void Lowering::visit_exit(const Instr &value) {
+    this->emit(Lir_Op::EXIT, this->operand(value));
+}
+
+void Lowering::visit_jmp(const Instr &target) {
+    // the target is a Txt holding the name of the label.
+    this->emit(Lir_Op::JMP, lbl_op(this->label(((const Txt &) target).value)));
+}
+
+void Lowering::visit_break() {
+    if (this->loops.empty()) crash("BREAK outside of a loop\n");
+    this->emit(Lir_Op::JMP, lbl_op(this->loops.back()));
+}
+
+void Lowering::visit_while(Instrs_View conditions, std::span<const Bool_Op> bool_ops, Instrs_View body) {
+    // the loop is rotated: the conditions are checked at the bottom,
+    // so every iteration runs a single branch.
+    auto id = "while." + std::to_string(this->counter++);
+    auto head = this->fresh(id + ".body");
+    auto test = this->fresh(id + ".test");
+    auto end = this->fresh(id + ".end");
+
+    this->emit(Lir_Op::JMP, lbl_op(test));
+    this->place(head);
+
+    this->loops.push_back(end);
+    this->visit(body);
+    this->loops.pop_back();
+
+    this->place(test);
+    this->branch(conditions, bool_ops, head, end, end);
+    this->place(end);
+}
+
+void Lowering::visit_for(const Instr &range_left, const Instr &range_right, const Instr &increment, Instrs_View body) {
+    // the counter goes from range_left (included) to range_right (excluded),
+    // it lives in a variable of its own the program can't name.
+    auto id = "for." + std::to_string(this->counter++);
+    auto left = this->operand(range_left);
+    auto right = this->operand(range_right);
+    auto step = this->operand(increment);
+
+    // with known bounds the body can be copied instead (-O).
+    bool known = left.kind == Operand_Kind::IMM && right.kind == Operand_Kind::IMM && step.kind == Operand_Kind::IMM && step.value > 0;
+    if (known && Optimizer::get_optimizer().enabled) {
+        this->unroll(id, left, right, step, body);
+        return;
+    }
+
+    auto head = this->fresh(id + ".body");
+    auto test = this->fresh(id + ".test");
+    auto end = this->fresh(id + ".end");
+
+    auto index = var_op(this->program.vars.size());
+    this->program.vars.push_back({ id, 0, true });
+
+    this->emit(Lir_Op::MOV, index, left);
+    this->emit(Lir_Op::JMP, lbl_op(test));
+    this->place(head);
+
+    this->loops.push_back(end);
+    this->visit(body);
+    this->loops.pop_back();
+
+    this->emit(Lir_Op::ADD, index, step);
+    this->place(test);
+    this->program.code.push_back({ Lir_Op::BR, LTH, index, right, head });
+    this->place(end);
+}
+
+void Lowering::unroll(const std::string &id, const Operand &left, const Operand &right, const Operand &step, Instrs_View body) {
+    auto &optimizer = Optimizer::get_optimizer();
+    auto end = this->fresh(id + ".end");
+
+    Body_Size size;
+    size.visit(body);
+    uint_t statements = std::max<uint_t>(size.statements, 1);
+    bool copyable = !size.labels && !size.loops;
+
+    // computed wide, no bound can overflow.
+    __int128 trips = right.value > left.value ? ((__int128) right.value - left.value + step.value - 1) / step.value : 0;
+
+    // copies of the body inside the loop, 1 keeps it as it is.
+    __int128 factor = 1;
+    if (copyable && trips <= (__int128) optimizer.full_unroll && trips * statements <= (__int128) UNROLL_BUDGET) {
+        // every iteration copied, no loop left.
+        factor = trips;
+        optimizer.stats.unrolled++;
+    } else if (copyable && optimizer.unroll > 1) {
+        factor = std::min<uint_t>(optimizer.unroll, UNROLL_BUDGET / statements);
+        if (factor > 1) optimizer.stats.unrolled++;
+        else factor = 1;
+    }
+
+    __int128 rounds = factor ? trips / factor : 0;
+    __int128 bound = left.value + rounds * factor * step.value;
+    __int128 increment = factor * step.value;
+    if (bound > INT64_MAX || increment > INT64_MAX) factor = 1, rounds = trips, bound = right.value, increment = step.value;
+
+    // the iterations that don't fill a round come after the loop.
+    __int128 rest = trips - rounds * factor;
+    this->loops.push_back(end);
+
+    // labels have to be placed even if the body never runs.
+    if ((rounds || !copyable) && factor != trips) {
+        auto head = this->fresh(id + ".body");
+        auto test = this->fresh(id + ".test");
+
+        auto index = var_op(this->program.vars.size());
+        this->program.vars.push_back({ id, 0, true });
+
+        this->emit(Lir_Op::MOV, index, left);
+        this->emit(Lir_Op::JMP, lbl_op(test));
+        this->place(head);
+        for (__int128 i = 0; i < factor; i++) this->visit(body);
+        this->emit(Lir_Op::ADD, index, imm_op((int64_t) increment));
+        this->place(test);
+        this->program.code.push_back({ Lir_Op::BR, LTH, index, imm_op((int64_t) bound), head });
+    } else {
+        rest = trips;
+    }
+
+    for (__int128 i = 0; i < rest; i++) this->visit(body);
+
+    this->loops.pop_back();
+    this->place(end);
+}
+
+void Lowering::visit_loop(Instrs_View body) {
+    auto id = "loop." + std::to_string(this->counter++);
+    auto head = this->fresh(id + ".body");
+    auto end = this->fresh(id + ".end");
+
+    this->place(head);
+
+    this->loops.push_back(end);
+    this->visit(body);
+    this->loops.pop_back();
+
+    this->emit(Lir_Op::JMP, lbl_op(head));
+    this->place(end);
+}
+
+void Lowering::visit_if(Instrs_View conditions, std::span<const Bool_Op> bool_ops, Instrs_View if_body, Instrs_View else_body) {
+    auto id = "if." + std::to_string(this->counter++);
+    auto then = this->fresh(id + ".then");
+    auto end = this->fresh(id + ".end");
+    auto other = else_body.empty() ? end : this->fresh(id + ".else");
+
+    this->branch(conditions, bool_ops, then, other, then);
+    this->place(then);
+    this->visit(if_body);
+
+    if (!else_body.empty()) {
+        this->emit(Lir_Op::JMP, lbl_op(end));
+        this->place(other);
+        this->visit(else_body);
+    }
+
+    this->place(end);
+}
+
+void Lowering::visit_cond(Cond_Op op, const Instr &lhs, const Instr &rhs) {
+    // conditions are lowered together with their chain by branch().
+    crash("If you see this message it means that there is an error inside the Parser.\n");
+}
+
+void Lowering::branch(Instrs_View conditions, std::span<const Bool_Op> bool_ops, uint32_t on_true, uint32_t on_false, uint32_t next) {
+    auto n = conditions.size();
+    if (!n) crash("If you see this message it means that there is an error inside the Parser.\n");
+
+    // the operators are applied from left to right: ((c0 op0 c1) op1 c2) ...
+    // going backward, every condition knows where to go once its result is known:
+    //  - before an '&&', a true result has to check the next condition, a false one is final.
+    //  - before an '||', a false result has to check the next condition, a true one is final.
+    std::vector<uint32_t> starts(n), on_trues(n), on_falses(n);
+    for (uint_t i = 1; i < n; i++) starts[i] = this->fresh("cond." + std::to_string(this->counter++));
+
+    on_trues[n - 1] = on_true;
+    on_falses[n - 1] = on_false;
+    for (uint_t i = n - 1; i > 0; i--) {
+        bool band = bool_ops[i - 1] == BAND;
+        on_trues[i - 1] = band ? starts[i] : on_trues[i];
+        on_falses[i - 1] = band ? on_falses[i] : starts[i];
+    }
+
+    for (uint_t i = 0; i < n; i++) {
+        if (i) this->place(starts[i]);
+
+        if (conditions[i]->kind() != Instr_Kind::COND) {
+            crash("If you see this message it means that there is an error inside the Parser.\n");
+        }
+
+        auto cond = (const Cond *) conditions[i].get();
+        auto a = this->operand(*cond->lhs);
+        auto b = this->operand(*cond->rhs);
+        auto after = i + 1 < n ? starts[i + 1] : next;
+
+        // falling through whenever one of the targets comes right after.
+        if (on_trues[i] == after) {
+            this->program.code.push_back({ Lir_Op::BR, negate(cond->op), a, b, on_falses[i] });
+        } else {
+            this->program.code.push_back({ Lir_Op::BR, cond->op, a, b, on_trues[i] });
+            if (on_falses[i] != after) this->emit(Lir_Op::JMP, lbl_op(on_falses[i]));
+        }
+    }
+}
+
+uint32_t Lowering::label(std::string_view name) {
+    std::string key(name);
+
+    auto it = this->labels.find(key);
+    if (it != this->labels.end()) return it->second;
+
+    // jumps can come before the label.
+    uint32_t label = this->program.labels.size();
+    this->program.labels.push_back({ key, true });
+    this->placed.push_back(false);
+    this->labels.emplace(key, label);
+
+    return label;
+}
+
+uint32_t Lowering::fresh(std::string name) {
+    uint32_t label = this->program.labels.size();
+    this->program.labels.push_back({ name, false });
+    this->placed.push_back(true);
+
+    return label;
+}
+
+Operand Lowering::operand(const Instr &instr) {
+    switch (instr.kind()) {
+        case Instr_Kind::VAR: {
+            // references keep the '.' of the token.
+            auto &name = ((const Var &) instr).name;
+            std::string key(name.starts_with('.') ? name.substr(1) : name);
+
+            auto constant = this->constants.find(key);
+            if (constant != this->constants.end()) return imm_op(constant->second);
+
+            auto var = this->vars.find(key);
+            if (var != this->vars.end()) return var_op(var->second);
+
+            crash("Undeclared variable '" + std::string(name) + "'\n");
+        } break;
+
+        case Instr_Kind::TXT: {
+            auto &value = ((const Txt &) instr).value;
+            if (!value.empty() && std::isdigit(value[0])) return imm_op(parse_int(value));
+            return reg_op(parse_reg(value));
+        }
+
+        default:
+            crash("If you see this message it means that there is an error inside the Parser.\n");
+    }
+
+    return {};
+}
+
+Operand Lowering::dest(const Instr &instr) {
+    auto op = this->operand(instr);
+    if (op.kind == Operand_Kind::IMM) crash("Invalid destination (Expected variable or register)\n");
+
+    return op;
+}
+
+void Lowering::finish() {
+    for (uint_t i = 0; i < this->placed.size(); i++) {
+        if (!this->placed[i]) crash("Undeclared label ':" + this->program.labels[i].name + "'\n");
+    }
+
+    // the chains of conditions craft more labels than needed,
+    // dropping the ones nobody jumps to.
+    std::vector<uint32_t> uses(this->program.labels.size(), 0);
+    for (auto &instr : this->program.code) {
+        if (instr.op == Lir_Op::JMP) uses[instr.a.value]++;
+        if (instr.op == Lir_Op::BR) uses[instr.target]++;
+    }
+
+    std::erase_if(this->program.code, [&](const Lir_Instr &instr) {
+        return instr.op == Lir_Op::LABEL && !this->program.labels[instr.a.value].user && !uses[instr.a.value];
+    });
+}
+
+}
+
+Lir_Program lower(const Instrs &instructions) {
+    Lowering lowering;
+
+    lowering.visit(instructions);
+    lowering.finish();
+
+    return std::move(lowering.program);
+}
@@ -0,0 +1,104 @@
+#ifndef OPT_H
+#define OPT_H
+
+#include "../InstructionSet.h"
+#include "Lir.h"
+#include "Peephole.h"
+
+// 'Opt.h' contains the optimizations of the lowered program.
+// Every pass keeps the exit value of the program as it is, the final values
+// of the variables aren't part of the result. The backends run the passes
+// through optimize() when -O is given.
+
+// Counters of what the passes changed.
+struct Opt_Stats {
+    // arithmetic instructions turned into a move of the result.
+    uint_t folded = 0;
+    // operands turned into immediates.
+    uint_t propagated = 0;
+    // branches with a known outcome, turned into a jump or dropped.
+    uint_t branches = 0;
+    // instructions no path from the entry reaches.
+    uint_t unreachable = 0;
+    // jumps and branches to the instruction right after them.
+    uint_t jumps = 0;
+    // labels nobody jumps to.
+    uint_t labels = 0;
+    // writes to registers and variables never read.
+    uint_t stores = 0;
+    // variables left without any use.
+    uint_t vars = 0;
+    // counted loops copied (fully or partially).
+    uint_t unrolled = 0;
+    // invariant moves taken out of their loop.
+    uint_t hoisted = 0;
+    // multiplications of an induction variable turned into additions.
+    uint_t reduced = 0;
+    // variables moved into a register.
+    uint_t promoted = 0;
+    // variables left in memory for lack of registers.
+    uint_t spilled = 0;
+    // hits of every peephole rule (see PEEPHOLE_RULES).
+    uint_t peephole[PEEP_RULE_COUNT] = {};
+};
+
+// Most statements a loop is allowed to grow to when its body is copied.
+inline constexpr uint_t UNROLL_BUDGET = 256;
+
+// Implementing the optimization settings as a singleton.
+class Optimizer {
+    public:
+        // Deleting copy c'tor.
+        explicit Optimizer(const Optimizer &other) = delete;
+
+        // Used to get an Optimizer reference.
+        static Optimizer &get_optimizer() {
+            static Optimizer optimizer;
+            return optimizer;
+        }
+
+        // Used to run every pass on a program (if enabled).
+        // The machine backends also get the variables moved into registers.
+        void run(Lir_Program &program, bool machine = false);
+
+        // the passes run only when enabled (-O).
+        bool enabled = false;
+        // counted loops (with literal bounds) running at most this many times are copied whole.
+        uint_t full_unroll = 16;
+        // copies of the body per iteration of the other counted loops (-unroll, 1 to turn off).
+        uint_t unroll = 4;
+        // what the passes changed so far.
+        Opt_Stats stats;
+    private:
+        // Default c'tor.
+        Optimizer() = default;
+};
+
+// Used to lower a program and optimize it (for a machine backend or not).
+Lir_Program optimize(const Instrs &instructions, bool machine = false);
+
+// Used to replace the values known at compile time with immediates, folding
+// the arithmetic and the branches on them (conditional constant propagation).
+void propagate_constants(Lir_Program &program, Opt_Stats &stats);
+
+// Used to remove the code that can't run (after exit, jmp and break), the
+// labels nobody jumps to and the writes nobody reads.
+// The final values of the variables are not part of the result of a program.
+void eliminate_dead_code(Lir_Program &program, Opt_Stats &stats);
+
+// Used to take the moves of invariant values out of the loops and to turn
+// t = i * C, with i moving by known steps, into additions to t (strength reduction).
+void optimize_loops(Lir_Program &program, Opt_Stats &stats);
+
+// Used to move the variables into the registers the program never names
+// (liveness and linear scan). A variable gets a register for its whole
+// live range or stays in memory, the ones used inside loops win.
+// The stack pointer, the frame pointer and the scratch register are never used.
+void allocate_registers(Lir_Program &program, Opt_Stats &stats);
+
+// Used to rewrite the short runs of instructions matching the rules of
+// 'Peephole.h' (self moves, reloads, neutral arithmetic, jumps to the next
+// instruction, ...) until none matches. It runs last, on what the backends get.
+void peephole(Lir_Program &program, Opt_Stats &stats);
+
+#endif // OPT_H
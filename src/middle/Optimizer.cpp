@@ -0,0 +1,27 @@
+#include "Opt.h"
+
+void Optimizer::run(Lir_Program &program, bool machine) {
+    if (!this->enabled) return;
+
+    propagate_constants(program, this->stats);
+    eliminate_dead_code(program, this->stats);
+
+    // the loops are easier to see once the dead code is gone.
+    optimize_loops(program, this->stats);
+    propagate_constants(program, this->stats);
+    eliminate_dead_code(program, this->stats);
+
+    if (machine) {
+        allocate_registers(program, this->stats);
+        // the variables living in registers are gone from memory.
+        eliminate_dead_code(program, this->stats);
+    }
+
+    peephole(program, this->stats);
+}
+
+Lir_Program optimize(const Instrs &instructions, bool machine) {
+    auto program = lower(instructions);
+    Optimizer::get_optimizer().run(program, machine);
+    return program;
+}
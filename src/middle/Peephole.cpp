@@ -0,0 +1,162 @@
+#include <algorithm>
+
+#include "Opt.h"
+#include "Peephole.h"
+
+namespace {
+
+// Used to know if a rule can be applied as written.
+constexpr bool well_formed(const Peep_Rule &rule) {
+    if (rule.length < 1 || rule.length > PEEP_WINDOW) return false;
+    if (rule.action == Peep_Action::DROP_LAST && rule.length < 2) return false;
+
+    // only a multiplication by 2^k has a shift.
+    auto &last = rule.pattern[rule.length - 1];
+    if (rule.action == Peep_Action::SHIFT) return rule.length == 1 && last.op == Lir_Op::MUL && last.b == Peep_Arg::POW2;
+    return true;
+}
+
+static_assert(std::ranges::all_of(PEEPHOLE_RULES, well_formed), "Malformed peephole rule.");
+static_assert(PEEP_RULE_COUNT <= UINT8_MAX, "Too many peephole rules.");
+
+// Rules ending with every operation, in the order of the table.
+struct Peep_Matcher {
+    uint8_t rules[LIR_OP_COUNT][PEEP_RULE_COUNT] = {};
+    uint8_t count[LIR_OP_COUNT] = {};
+};
+
+constexpr Peep_Matcher build_matcher() {
+    Peep_Matcher matcher;
+    for (uint_t r = 0; r < PEEP_RULE_COUNT; r++) {
+        auto &rule = PEEPHOLE_RULES[r];
+        auto op = (uint_t) rule.pattern[rule.length - 1].op;
+        matcher.rules[op][matcher.count[op]++] = r;
+    }
+
+    return matcher;
+}
+
+// built with xtasm, matching never walks the whole table.
+constexpr Peep_Matcher MATCHER = build_matcher();
+
+// Operands bound to X and Y while matching a rule.
+struct Bindings {
+    Operand x, y;
+    bool has_x = false;
+    bool has_y = false;
+};
+
+// Used to know if an operand fits the argument of a pattern, binding X and Y.
+bool accepts(Peep_Arg arg, const Operand &op, Bindings &bound) {
+    switch (arg) {
+        case Peep_Arg::ANY:
+            return true;
+
+        case Peep_Arg::ZERO:
+            return op.kind == Operand_Kind::IMM && op.value == 0;
+
+        case Peep_Arg::ONE:
+            return op.kind == Operand_Kind::IMM && op.value == 1;
+
+        case Peep_Arg::POW2:
+            return op.kind == Operand_Kind::IMM && op.value > 1 && !(op.value & (op.value - 1));
+
+        case Peep_Arg::X:
+        case Peep_Arg::Y: {
+            bool x = arg == Peep_Arg::X;
+            auto &slot = x ? bound.x : bound.y;
+            auto &has = x ? bound.has_x : bound.has_y;
+            if (has) return slot == op;
+
+            // X and Y are different operands.
+            if (x ? bound.has_y && bound.y == op : bound.has_x && bound.x == op) return false;
+            slot = op;
+            has = true;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Used to know if the instructions starting at run match a rule.
+bool matches(const Peep_Rule &rule, const Lir_Instr *run) {
+    Bindings bound;
+    for (uint_t i = 0; i < rule.length; i++) {
+        auto &pattern = rule.pattern[i];
+        auto &instr = run[i];
+
+        if (pattern.op != instr.op) return false;
+        if (!accepts(pattern.a, instr.a, bound) || !accepts(pattern.b, instr.b, bound)) return false;
+        if (instr.op == Lir_Op::BR && !accepts(pattern.target, lbl_op(instr.target), bound)) return false;
+    }
+
+    return true;
+}
+
+// Rewrites the program through the rules of the table.
+class Peephole {
+    public:
+        explicit Peephole(Lir_Program &program, Opt_Stats &stats) : program(program), stats(stats) {}
+
+        void run();
+    private:
+        // Used to apply the first rule matching the end of the code, false if none does.
+        bool rewrite();
+
+        Lir_Program &program;
+        Opt_Stats &stats;
+        // instructions already rewritten.
+        std::vector<Lir_Instr> code;
+};
+
+bool Peephole::rewrite() {
+    auto op = (uint_t) this->code.back().op;
+
+    for (uint_t k = 0; k < MATCHER.count[op]; k++) {
+        auto r = MATCHER.rules[op][k];
+        auto &rule = PEEPHOLE_RULES[r];
+        if (rule.length > this->code.size() || !matches(rule, this->code.data() + this->code.size() - rule.length)) continue;
+
+        auto first = this->code.end() - rule.length;
+        switch (rule.action) {
+            case Peep_Action::DROP_FIRST:
+                this->code.erase(first);
+                break;
+
+            case Peep_Action::DROP_LAST:
+                this->code.pop_back();
+                break;
+
+            case Peep_Action::SHIFT:
+                first->op = Lir_Op::SHL;
+                first->b = imm_op(__builtin_ctzll(first->b.value));
+                break;
+        }
+
+        this->stats.peephole[r]++;
+        return true;
+    }
+
+    return false;
+}
+
+void Peephole::run() {
+    this->code.reserve(this->program.code.size());
+
+    // a rewrite only changes the end of the code, retrying there until no rule
+    // matches keeps the whole code at the fixpoint in a single sweep.
+    for (auto &instr : this->program.code) {
+        this->code.push_back(instr);
+        while (!this->code.empty() && this->rewrite()) {}
+    }
+
+    this->program.code = std::move(this->code);
+}
+
+}
+
+void peephole(Lir_Program &program, Opt_Stats &stats) {
+    Peephole pass(program, stats);
+    pass.run();
+}
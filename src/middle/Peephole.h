@@ -0,0 +1,86 @@
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+
+#include "Lir.h"
+
+// 'Peephole.h' contains the rules of the peephole pass: short runs of
+// adjacent instructions and what they become. The table is checked and
+// turned into a matcher (the rules ending with every operation) at compile
+// time, see 'Peephole.cpp'. A new rule is a new line of PEEPHOLE_RULES.
+
+// What an operand of a pattern accepts.
+enum class Peep_Arg : uint8_t {
+    // anything, a missing operand too.
+    ANY,
+    // the same operand everywhere X appears (Y likewise), X and Y never match the same one.
+    X,
+    Y,
+    // immediate 0.
+    ZERO,
+    // immediate 1.
+    ONE,
+    // immediate power of two above 1.
+    POW2,
+};
+
+// What a matched run becomes.
+enum class Peep_Action : uint8_t {
+    // the first instruction goes away.
+    DROP_FIRST,
+    // the last instruction goes away.
+    DROP_LAST,
+    // the multiplication by 2^k becomes a shift by k.
+    SHIFT,
+};
+
+// Instruction of a pattern.
+struct Peep_Instr {
+    Lir_Op op;
+    Peep_Arg a = Peep_Arg::ANY;
+    Peep_Arg b = Peep_Arg::ANY;
+    // label reached by a BR.
+    Peep_Arg target = Peep_Arg::ANY;
+};
+
+// Longest run of instructions a rule can match.
+inline constexpr uint_t PEEP_WINDOW = 2;
+
+struct Peep_Rule {
+    // name printed by -stats.
+    std::string_view name;
+    // instructions of the pattern.
+    uint8_t length;
+    Peep_Instr pattern[PEEP_WINDOW];
+    Peep_Action action;
+};
+
+// Table of the rules, tried in order.
+inline constexpr Peep_Rule PEEPHOLE_RULES[] = {
+    // mov x, x.
+    { "mov.self", 1, { { Lir_Op::MOV, Peep_Arg::X, Peep_Arg::X } }, Peep_Action::DROP_FIRST },
+    // add x, 0.
+    { "add.zero", 1, { { Lir_Op::ADD, Peep_Arg::ANY, Peep_Arg::ZERO } }, Peep_Action::DROP_FIRST },
+    // sub x, 0.
+    { "sub.zero", 1, { { Lir_Op::SUB, Peep_Arg::ANY, Peep_Arg::ZERO } }, Peep_Action::DROP_FIRST },
+    // mul x, 1.
+    { "mul.one", 1, { { Lir_Op::MUL, Peep_Arg::ANY, Peep_Arg::ONE } }, Peep_Action::DROP_FIRST },
+    // mul x, 2^k  ->  shl x, k.
+    { "mul.pow2", 1, { { Lir_Op::MUL, Peep_Arg::ANY, Peep_Arg::POW2 } }, Peep_Action::SHIFT },
+    // mov x, y; mov y, x: y already holds x (store then reload).
+    { "mov.reload", 2, { { Lir_Op::MOV, Peep_Arg::X, Peep_Arg::Y }, { Lir_Op::MOV, Peep_Arg::Y, Peep_Arg::X } }, Peep_Action::DROP_LAST },
+    // mov x, _; mov x, y: nobody reads the first value.
+    { "mov.overwritten", 2, { { Lir_Op::MOV, Peep_Arg::X }, { Lir_Op::MOV, Peep_Arg::X, Peep_Arg::Y } }, Peep_Action::DROP_FIRST },
+    // jmp l; l:
+    { "jmp.next", 2, { { Lir_Op::JMP, Peep_Arg::X }, { Lir_Op::LABEL, Peep_Arg::X } }, Peep_Action::DROP_FIRST },
+    // br _, _, l; l:
+    { "br.next", 2, { { Lir_Op::BR, Peep_Arg::ANY, Peep_Arg::ANY, Peep_Arg::X }, { Lir_Op::LABEL, Peep_Arg::X } }, Peep_Action::DROP_FIRST },
+};
+
+// Number of rules.
+inline constexpr uint_t PEEP_RULE_COUNT = std::size(PEEPHOLE_RULES);
+
+#endif // PEEPHOLE_H
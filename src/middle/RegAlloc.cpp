@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <optional>
+
+#include "Cfg.h"
+#include "Liveness.h"
+#include "Opt.h"
+
+namespace {
+
+// Deepest loop nesting that still weighs more.
+constexpr uint32_t MAX_WEIGHT_DEPTH = 8;
+
+// Registers handed out, the ones the exit code needs last.
+constexpr int64_t ALLOCATABLE[] = { 1, 2, 6, 8, 9, 10, 3, 12, 13, 14, 15, 7, 0 };
+
+// Range of instructions where a variable is (maybe) live.
+struct Interval {
+    uint32_t var;
+    uint32_t start;
+    uint32_t end;
+    // uses, weighed by their loop depth.
+    uint64_t weight = 0;
+    // register given, -1 when the variable stays in memory.
+    int64_t reg = -1;
+};
+
+// Maps the variables onto the registers the program leaves free (linear scan).
+class Allocation {
+    public:
+        explicit Allocation(Lir_Program &program, Opt_Stats &stats) : program(program), stats(stats), cfg(program) {}
+
+        void run();
+    private:
+        // Used to build the interval of every variable.
+        void intervals();
+        // Used to give a register to as many intervals as possible.
+        void scan();
+        // Used to rewrite the program with the registers.
+        void rewrite();
+
+        Lir_Program &program;
+        Opt_Stats &stats;
+        Cfg cfg;
+        // solved only when affordable.
+        std::optional<Liveness> live;
+        // interval of every variable (start > end if never used).
+        std::vector<Interval> ranges;
+};
+
+void Allocation::intervals() {
+    auto &blocks = this->cfg.blocks;
+    auto &code = this->program.code;
+
+    this->ranges.clear();
+    for (uint32_t var = 0; var < this->program.vars.size(); var++) this->ranges.push_back({ var, UINT32_MAX, 0 });
+
+    auto cover = [&](uint_t var, uint32_t pos) {
+        auto &range = this->ranges[var];
+        range.start = std::min(range.start, pos);
+        range.end = std::max(range.end, pos);
+    };
+
+    for (uint32_t b = 0; b < blocks.size(); b++) {
+        if (!this->cfg.reachable(b)) continue;
+
+        // loops run more often, their uses weigh more.
+        uint64_t weight = 1ull << (3 * std::min(this->cfg.depth(b), MAX_WEIGHT_DEPTH));
+
+        this->live->live_in[b].each([&](uint_t loc) {
+            if (loc >= REG_COUNT) cover(loc - REG_COUNT, blocks[b].first);
+        });
+        this->live->live_out[b].each([&](uint_t loc) {
+            if (loc >= REG_COUNT) cover(loc - REG_COUNT, blocks[b].end - 1);
+        });
+        for (auto i = blocks[b].first; i < blocks[b].end; i++) {
+            locations(code[i], [&](uint_t loc, bool) {
+                if (loc < REG_COUNT) return;
+                cover(loc - REG_COUNT, i);
+                this->ranges[loc - REG_COUNT].weight += weight;
+            });
+        }
+    }
+}
+
+void Allocation::scan() {
+    // registers the program doesn't name.
+    std::vector<bool> named(REG_COUNT, false);
+    for (auto &instr : this->program.code) {
+        if (instr.a.kind == Operand_Kind::REG) named[instr.a.value] = true;
+        if (instr.b.kind == Operand_Kind::REG) named[instr.b.value] = true;
+    }
+
+    std::vector<int64_t> free;
+    for (auto it = std::rbegin(ALLOCATABLE); it != std::rend(ALLOCATABLE); it++) {
+        if (!named[*it]) free.push_back(*it);
+    }
+
+    std::vector<Interval *> order;
+    for (auto &range : this->ranges) {
+        if (range.start <= range.end) order.push_back(&range);
+    }
+    std::sort(order.begin(), order.end(), [](auto l, auto r) { return l->start < r->start; });
+
+    // intervals holding a register.
+    std::vector<Interval *> active;
+    for (auto current : order) {
+        // the intervals over before this one give their register back.
+        std::erase_if(active, [&](Interval *range) {
+            if (range->end >= current->start) return false;
+            free.push_back(range->reg);
+            return true;
+        });
+
+        if (!free.empty()) {
+            current->reg = free.back();
+            free.pop_back();
+            active.push_back(current);
+            continue;
+        }
+
+        // no register left, the lightest interval stays in memory.
+        auto lightest = std::min_element(active.begin(), active.end(), [](auto l, auto r) { return l->weight < r->weight; });
+        if (lightest == active.end() || (*lightest)->weight >= current->weight) {
+            this->stats.spilled++;
+            continue;
+        }
+
+        current->reg = (*lightest)->reg;
+        (*lightest)->reg = -1;
+        *lightest = current;
+        this->stats.spilled++;
+    }
+
+    for (auto &range : this->ranges) {
+        if (range.reg >= 0) this->stats.promoted++;
+    }
+}
+
+void Allocation::rewrite() {
+    auto &code = this->program.code;
+    auto entry = this->cfg.blocks.empty() ? NO_BLOCK : 0;
+
+    // the variables read before any write start with their initial value.
+    std::vector<Lir_Instr> init;
+    for (auto &range : this->ranges) {
+        if (range.reg < 0 || entry == NO_BLOCK || !this->live->live_in[entry].has(REG_COUNT + range.var)) continue;
+        init.push_back({ Lir_Op::MOV, EQU, reg_op(range.reg), imm_op(this->program.vars[range.var].value), 0 });
+    }
+
+    for (auto &instr : code) {
+        for (auto op : { &instr.a, &instr.b }) {
+            if (op->kind == Operand_Kind::VAR && this->ranges[op->value].reg >= 0) *op = reg_op(this->ranges[op->value].reg);
+        }
+    }
+
+    // before the first label, jumps back to the start don't run it again.
+    code.insert(code.begin(), init.begin(), init.end());
+}
+
+void Allocation::run() {
+    if (!Liveness::affordable(this->program, this->cfg)) return;
+
+    this->live.emplace(this->program, this->cfg);
+    this->intervals();
+    this->scan();
+    this->rewrite();
+}
+
+}
+
+void allocate_registers(Lir_Program &program, Opt_Stats &stats) {
+    if (program.code.empty() || program.vars.empty()) return;
+
+    Allocation allocation(program, stats);
+    allocation.run();
+}
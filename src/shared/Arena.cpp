@@ -0,0 +1,39 @@
+#include "Arena.h"
+
+#include <cstdint>
+#include <new>
+
+void Arena::release() {
+    // freeing every chunk, no matter what was allocated inside.
+    while (this->chunks) {
+        auto next = this->chunks->next;
+        ::operator delete(this->chunks);
+        this->chunks = next;
+    }
+
+    this->cursor = nullptr;
+    this->limit = nullptr;
+}
+
+void *Arena::do_allocate(std::size_t bytes, std::size_t alignment) {
+    // bumping the cursor inside the current chunk.
+    auto ptr = (char *) (((uintptr_t) this->cursor + alignment - 1) & ~(uintptr_t) (alignment - 1));
+
+    if (!this->cursor || ptr + bytes > this->limit) {
+        // the current chunk is full, crafting a new one big enough.
+        uint_t size = sizeof(Chunk) + alignment + bytes;
+        if (size < this->chunk_size) size = this->chunk_size;
+
+        auto chunk = (Chunk *) ::operator new(size);
+        chunk->next = this->chunks;
+        this->chunks = chunk;
+
+        this->cursor = (char *) (chunk + 1);
+        this->limit = (char *) chunk + size;
+
+        ptr = (char *) (((uintptr_t) this->cursor + alignment - 1) & ~(uintptr_t) (alignment - 1));
+    }
+
+    this->cursor = ptr + bytes;
+    return ptr;
+}
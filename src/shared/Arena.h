@@ -0,0 +1,56 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+
+#include "Basic.h"
+
+// Bump allocator, memory is never freed one allocation at a time:
+// everything is released at once when the Arena is destroyed.
+// It's a pmr resource, so pmr containers and strings can live inside it.
+// Not thread safe.
+class Arena : public std::pmr::memory_resource {
+    public:
+        // Used to craft an arena growing by chunks of (at least) chunk_size bytes.
+        explicit Arena(uint_t chunk_size = 64 * 1024) : chunk_size(chunk_size) {}
+        // Deleting copy c'tor.
+        explicit Arena(const Arena &other) = delete;
+        // Destructor.
+        ~Arena() { this->release(); }
+
+        // Used to free every allocation at once.
+        void release();
+
+        // Used to make an Arena the default pmr resource while the Scope is alive.
+        class Scope {
+            public:
+                explicit Scope(Arena &arena) : previous(std::pmr::set_default_resource(&arena)) {}
+                // Deleting copy c'tor.
+                explicit Scope(const Scope &other) = delete;
+                ~Scope() { std::pmr::set_default_resource(this->previous); }
+            private:
+                std::pmr::memory_resource *previous;
+        };
+    private:
+        void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+        // single allocations are never freed.
+        void do_deallocate(void *ptr, std::size_t bytes, std::size_t alignment) override {}
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+        // Header placed at the start of every chunk.
+        struct Chunk {
+            Chunk *next;
+        };
+
+        // minimum size of a new chunk.
+        uint_t chunk_size;
+        // list of the allocated chunks (last one first).
+        Chunk *chunks = nullptr;
+        // first free byte of the current chunk.
+        char *cursor = nullptr;
+        // end of the current chunk.
+        char *limit = nullptr;
+};
+
+#endif // ARENA_H
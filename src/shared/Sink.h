@@ -0,0 +1,114 @@
+#ifndef SINK_H
+#define SINK_H
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "Basic.h"
+
+// Buffered output used by the backends to emit code.
+// Writes are appended to a fixed buffer, which is handed to drain() in
+// chunks when it's full, so the output never has to be kept in memory.
+// Writing is inline on purpose: plugins can use a Sink without linking
+// against xtasm, only drain() goes through the vtable.
+class Sink {
+    public:
+        // Used to craft a sink flushing every capacity bytes.
+        explicit Sink(uint_t capacity = 64 * 1024) : buf(new char[capacity]), capacity(capacity) {}
+        // Deleting copy c'tor.
+        explicit Sink(const Sink &other) = delete;
+        // Destructor (subclasses flush in their own destructor).
+        virtual ~Sink() = default;
+
+        // Used to append some text.
+        void write(std::string_view str) {
+            // big writes skip the buffer.
+            if (str.length() >= this->capacity) {
+                this->flush();
+                this->drain(str.data(), str.length());
+                return;
+            }
+
+            if (this->size + str.length() > this->capacity) this->flush();
+            std::memcpy(this->buf.get() + this->size, str.data(), str.length());
+            this->size += str.length();
+        }
+
+        // Used to append a single character.
+        void put(char c) {
+            if (this->size == this->capacity) this->flush();
+            this->buf[this->size++] = c;
+        }
+
+        // Used to append a signed integer in base 10.
+        void write_int(long int value) {
+            char digits[24];
+            uint_t len = 0;
+            // working with the unsigned value, -LONG_MIN doesn't fit a long.
+            unsigned long int abs = value < 0 ? 0ul - value : value;
+
+            do {
+                digits[sizeof(digits) - ++len] = '0' + abs % 10;
+                abs /= 10;
+            } while (abs);
+            if (value < 0) digits[sizeof(digits) - ++len] = '-';
+
+            this->write(std::string_view(digits + sizeof(digits) - len, len));
+        }
+
+        Sink &operator<<(std::string_view str) { this->write(str); return *this; }
+        Sink &operator<<(char c) { this->put(c); return *this; }
+
+        // Used to hand the buffered bytes to the destination.
+        void flush() {
+            if (this->size) this->drain(this->buf.get(), this->size);
+            this->size = 0;
+        }
+    protected:
+        // Used to send a chunk of bytes to the destination.
+        virtual void drain(const char *data, uint_t len) = 0;
+    private:
+        // pending bytes.
+        std::unique_ptr<char[]> buf;
+        // number of pending bytes.
+        uint_t size = 0;
+        // length of buf.
+        uint_t capacity;
+};
+
+// Sink writing into a file descriptor (not closed at the end).
+class Fd_Sink : public Sink {
+    public:
+        explicit Fd_Sink(int fd) : fd(fd) {}
+        ~Fd_Sink() { this->flush(); }
+    protected:
+        void drain(const char *data, uint_t len) override;
+        // destination.
+        int fd;
+};
+
+// Sink writing into a file, created (with the given permissions) or truncated.
+class File_Sink : public Fd_Sink {
+    public:
+        explicit File_Sink(std::string filepath, int mode = 0644);
+        ~File_Sink();
+};
+
+// Sink collecting everything in memory.
+class Memory_Sink : public Sink {
+    public:
+        explicit Memory_Sink() = default;
+        ~Memory_Sink() { this->flush(); }
+
+        // Used to get what was written so far.
+        std::string &str() { this->flush(); return this->out; }
+    protected:
+        void drain(const char *data, uint_t len) override { this->out.append(data, len); }
+    private:
+        // the whole output.
+        std::string out;
+};
+
+#endif // SINK_H
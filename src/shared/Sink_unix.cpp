@@ -0,0 +1,34 @@
+#include "Sink.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+void Fd_Sink::drain(const char *data, uint_t len) {
+    // write can be partial, looping until everything is out.
+    while (len) {
+        auto n = ::write(this->fd, data, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            auto msg = std::string("Unable to write the output. ") + std::strerror(errno);
+            crash(msg);
+        }
+
+        data += n;
+        len -= n;
+    }
+}
+
+File_Sink::File_Sink(std::string filepath, int mode) : Fd_Sink(::open(filepath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, mode)) {
+    if (this->fd < 0) {
+        auto msg = "Unable to open '" + filepath + "'. " + std::strerror(errno);
+        crash(msg);
+    }
+}
+
+File_Sink::~File_Sink() {
+    // the pending bytes have to be out before closing.
+    this->flush();
+    ::close(this->fd);
+}
@@ -0,0 +1,188 @@
+#include "Bytecode.h"
+#include "../middle/Opt.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+
+// Pairs of instructions worth one dispatch instead of two, picked from the
+// -vmprof counts of loop-heavy programs: the counter of a loop stepped right
+// before its test, the step before the jump back of a 'loop', moves in a row.
+// The fused instruction keeps a and b of the first one, takes c (the target of
+// a jump, a slot otherwise) and d (b) of the second one.
+struct Fusion {
+    Bc_Op first;
+    Bc_Op second;
+    Bc_Op fused;
+    // the second instruction has to work on the slot written by the first one.
+    bool same_slot;
+};
+
+constexpr Fusion FUSIONS[] = {
+    { Bc_Op::ADD, Bc_Op::BR_EQU, Bc_Op::ADD_BR_EQU, true },
+    { Bc_Op::ADD, Bc_Op::BR_NEQU, Bc_Op::ADD_BR_NEQU, true },
+    { Bc_Op::ADD, Bc_Op::BR_LTH, Bc_Op::ADD_BR_LTH, true },
+    { Bc_Op::ADD, Bc_Op::BR_LTE, Bc_Op::ADD_BR_LTE, true },
+    { Bc_Op::ADD, Bc_Op::BR_GT, Bc_Op::ADD_BR_GT, true },
+    { Bc_Op::ADD, Bc_Op::BR_GTE, Bc_Op::ADD_BR_GTE, true },
+    { Bc_Op::SUB, Bc_Op::BR_EQU, Bc_Op::SUB_BR_EQU, true },
+    { Bc_Op::SUB, Bc_Op::BR_NEQU, Bc_Op::SUB_BR_NEQU, true },
+    { Bc_Op::SUB, Bc_Op::BR_LTH, Bc_Op::SUB_BR_LTH, true },
+    { Bc_Op::SUB, Bc_Op::BR_LTE, Bc_Op::SUB_BR_LTE, true },
+    { Bc_Op::SUB, Bc_Op::BR_GT, Bc_Op::SUB_BR_GT, true },
+    { Bc_Op::SUB, Bc_Op::BR_GTE, Bc_Op::SUB_BR_GTE, true },
+    { Bc_Op::ADD, Bc_Op::JMP, Bc_Op::ADD_JMP, false },
+    { Bc_Op::SUB, Bc_Op::JMP, Bc_Op::SUB_JMP, false },
+    { Bc_Op::MOV, Bc_Op::MOV, Bc_Op::MOV_MOV, false },
+};
+
+// Used to replace the first instruction of every known pair with its superinstruction.
+// The second one stays in place, jumps can still land on it.
+void fuse_pairs(std::vector<Bc_Instr> &code) {
+    for (uint_t i = 0; i + 1 < code.size(); i++) {
+        auto &first = code[i];
+        auto &second = code[i + 1];
+
+        for (auto &fusion : FUSIONS) {
+            if (fusion.first != first.op || fusion.second != second.op) continue;
+            if (fusion.same_slot && second.a != first.a) continue;
+
+            first = { fusion.fused, {}, first.a, first.b, is_jump(second.op) ? second.c : second.a, second.b };
+            break;
+        }
+    }
+}
+
+// Translates the lowered instructions one by one.
+class Assembler {
+    public:
+        explicit Assembler(const Lir_Program &program);
+
+        // the translated program.
+        Bytecode bytecode;
+
+        // Used to translate the whole program.
+        void assemble();
+    private:
+        // Used to get the slot of an operand.
+        uint32_t slot(const Operand &op);
+
+        const Lir_Program &program;
+        // slots of the constants by value.
+        std::unordered_map<int64_t, uint32_t> constants;
+};
+
+Assembler::Assembler(const Lir_Program &program) : program(program) {
+    this->bytecode.slots.assign(REG_COUNT, 0);
+    for (auto &var : program.vars) this->bytecode.slots.push_back(var.bss ? 0 : var.value);
+    this->bytecode.const_base = this->bytecode.slots.size();
+}
+
+uint32_t Assembler::slot(const Operand &op) {
+    switch (op.kind) {
+        case Operand_Kind::REG:
+            return op.value;
+
+        case Operand_Kind::VAR:
+            return this->bytecode.var_base + op.value;
+
+        case Operand_Kind::IMM: {
+            auto [it, added] = this->constants.try_emplace(op.value, this->bytecode.slots.size());
+            if (added) this->bytecode.slots.push_back(op.value);
+            return it->second;
+        }
+
+        default:
+            crash("Invalid operand inside the lowered program.\n");
+    }
+
+    return 0;
+}
+
+void Assembler::assemble() {
+    auto &code = this->bytecode.code;
+    // index of the instruction following every label.
+    std::vector<uint32_t> targets(this->program.labels.size(), 0);
+
+    for (auto &instr : this->program.code) {
+        switch (instr.op) {
+            case Lir_Op::LABEL:
+                targets[instr.a.value] = code.size();
+                break;
+
+            case Lir_Op::MOV:
+            case Lir_Op::ADD:
+            case Lir_Op::SUB:
+            case Lir_Op::MUL:
+            case Lir_Op::SHL: {
+                // same order as Lir_Op.
+                auto op = (Bc_Op) ((int) Bc_Op::MOV + (int) instr.op - (int) Lir_Op::MOV);
+                code.push_back({ op, {}, this->slot(instr.a), this->slot(instr.b), 0 });
+            } break;
+
+            case Lir_Op::JMP:
+                code.push_back({ Bc_Op::JMP, {}, 0, 0, (uint32_t) instr.a.value });
+                break;
+
+            case Lir_Op::BR: {
+                // same order as Cond_Op.
+                auto op = (Bc_Op) ((int) Bc_Op::BR_EQU + instr.cond);
+                code.push_back({ op, {}, this->slot(instr.a), this->slot(instr.b), instr.target });
+            } break;
+
+            case Lir_Op::EXIT:
+                code.push_back({ Bc_Op::EXIT, {}, this->slot(instr.a), 0, 0 });
+                break;
+        }
+    }
+
+    // the jumps held labels until every one was placed.
+    for (auto &instr : code) {
+        if (is_jump(instr.op)) instr.c = targets[instr.c];
+    }
+}
+
+}
+
+Bytecode assemble(const Lir_Program &program, bool fuse) {
+    Assembler assembler(program);
+    assembler.assemble();
+    if (fuse) fuse_pairs(assembler.bytecode.code);
+
+    return std::move(assembler.bytecode);
+}
+
+int64_t run_bytecode(const Instrs &instructions) {
+    auto bytecode = assemble(optimize(instructions));
+    auto slots = bytecode.slots;
+    return interpret(bytecode, slots);
+}
+
+int64_t profile_bytecode(const Instrs &instructions, Sink &out) {
+    auto bytecode = assemble(optimize(instructions), false);
+    auto slots = bytecode.slots;
+    Bc_Profile pairs(BC_OP_COUNT);
+    auto value = profile(bytecode, slots, pairs);
+
+    struct Pair {
+        uint64_t count;
+        uint_t first, second;
+    };
+
+    std::vector<Pair> sorted;
+    for (uint_t first = 0; first < BC_OP_COUNT; first++) {
+        for (uint_t second = 0; second < BC_OP_COUNT; second++) {
+            if (pairs[first][second]) sorted.push_back({ pairs[first][second], first, second });
+        }
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const Pair &l, const Pair &r) { return l.count > r.count; });
+
+    for (auto &pair : sorted) {
+        out.write_int(pair.count);
+        out << '\t' << BC_OP_NAMES[pair.first] << ' ' << BC_OP_NAMES[pair.second] << '\n';
+    }
+    out.flush();
+
+    return value;
+}
@@ -0,0 +1,128 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "../InstructionSet.h"
+#include "../middle/Lir.h"
+#include "../shared/Sink.h"
+
+// 'Bytecode.h' contains a portable form of the lowered program, run by an
+// interpreter instead of the machine (see 'Vm.cpp').
+// Every operand is a slot: the registers come first, then the variables,
+// then the constants, so a single instruction shape covers all of them.
+// The comparison of a branch is part of its opcode, one dispatch per instruction.
+// Frequent pairs of instructions are fused into superinstructions (see FUSIONS
+// in 'Bytecode.cpp'), the second one stays in place and is skipped.
+
+// Opcodes of the bytecode.
+enum class Bc_Op : uint8_t {
+    // a = b.
+    MOV,
+    // a += b.
+    ADD,
+    // a -= b.
+    SUB,
+    // a *= b.
+    MUL,
+    // a <<= b.
+    SHL,
+    // goto c.
+    JMP,
+    // if (a cond b) goto c.
+    BR_EQU,
+    BR_NEQU,
+    BR_LTH,
+    BR_LTE,
+    BR_GT,
+    BR_GTE,
+    // terminates the program with a.
+    EXIT,
+
+    // superinstructions.
+    // a += b; if (a cond d) goto c.
+    ADD_BR_EQU,
+    ADD_BR_NEQU,
+    ADD_BR_LTH,
+    ADD_BR_LTE,
+    ADD_BR_GT,
+    ADD_BR_GTE,
+    // a -= b; if (a cond d) goto c.
+    SUB_BR_EQU,
+    SUB_BR_NEQU,
+    SUB_BR_LTH,
+    SUB_BR_LTE,
+    SUB_BR_GT,
+    SUB_BR_GTE,
+    // a += b; goto c.
+    ADD_JMP,
+    // a -= b; goto c.
+    SUB_JMP,
+    // a = b; c = d.
+    MOV_MOV,
+};
+
+// Number of opcodes.
+inline constexpr uint_t BC_OP_COUNT = (uint_t) Bc_Op::MOV_MOV + 1;
+
+// Names of the opcodes.
+inline constexpr std::string_view BC_OP_NAMES[BC_OP_COUNT] = {
+    "mov", "add", "sub", "mul", "shl", "jmp",
+    "br.equ", "br.nequ", "br.lth", "br.lte", "br.gt", "br.gte",
+    "exit",
+    "add.br.equ", "add.br.nequ", "add.br.lth", "add.br.lte", "add.br.gt", "add.br.gte",
+    "sub.br.equ", "sub.br.nequ", "sub.br.lth", "sub.br.lte", "sub.br.gt", "sub.br.gte",
+    "add.jmp", "sub.jmp", "mov.mov",
+};
+
+// Instruction of fixed width (20 bytes).
+struct Bc_Instr {
+    Bc_Op op;
+    uint8_t unused[3] = {};
+    // slots.
+    uint32_t a = 0;
+    uint32_t b = 0;
+    // index of the instruction reached by a jump (or a slot).
+    uint32_t c = 0;
+    // slot used by the superinstructions.
+    uint32_t d = 0;
+};
+
+// Used to know if an instruction is a jump (it has a target in c).
+inline bool is_jump(Bc_Op op) {
+    return op == Bc_Op::JMP || (op >= Bc_Op::BR_EQU && op <= Bc_Op::BR_GTE) || (op >= Bc_Op::ADD_BR_EQU && op <= Bc_Op::SUB_JMP);
+}
+
+struct Bytecode {
+    std::vector<Bc_Instr> code;
+    // initial value of every slot.
+    std::vector<int64_t> slots;
+    // first slot of the variables (the registers come before).
+    uint32_t var_base = REG_COUNT;
+    // first slot of the constants.
+    uint32_t const_base = REG_COUNT;
+};
+
+// Used to translate a lowered program into bytecode, optionally fusing superinstructions.
+Bytecode assemble(const Lir_Program &program, bool fuse = true);
+
+// Used to interpret a program, returning the value of Exit.
+// slots holds the initial values and is left as the program left it.
+int64_t interpret(const Bytecode &bytecode, std::vector<int64_t> &slots);
+
+// Times every pair of opcodes executed one after the other, [first][second].
+using Bc_Profile = std::vector<std::array<uint64_t, BC_OP_COUNT>>;
+
+// Used to interpret a program (slowly) while counting the executed pairs of opcodes.
+int64_t profile(const Bytecode &bytecode, std::vector<int64_t> &slots, Bc_Profile &pairs);
+
+// Used to run a program on the interpreter, returning the value of Exit.
+int64_t run_bytecode(const Instrs &instructions);
+
+// Used to run a program without superinstructions, writing the most frequent pairs of opcodes into out.
+int64_t profile_bytecode(const Instrs &instructions, Sink &out);
+
+#endif // BYTECODE_H
@@ -0,0 +1,112 @@
+#include "Bytecode.h"
+
+// The interpreter dispatches with computed gotos where the compiler has them
+// (GCC and Clang), every handler jumps straight to the next one, otherwise
+// it falls back to a switch inside a loop.
+#if defined(__GNUC__)
+#define XT_THREADED 1
+#endif
+
+#if XT_THREADED
+#define HANDLER(name) do_##name:
+#define JUMP() goto *HANDLERS[(int) ip->op]
+#else
+#define HANDLER(name) case Bc_Op::name:
+#define JUMP() continue
+#endif
+
+// Used to run the instruction at ip (counting the pair when profiling).
+#define DISPATCH() do { if constexpr (PROFILE) count(ip->op); JUMP(); } while (0)
+// Used to go on with the following instruction.
+#define NEXT() do { ip++; DISPATCH(); } while (0)
+// Used to branch to c if the comparison holds.
+#define BRANCH(cmp) do { ip = s[ip->a] cmp s[ip->b] ? code + ip->c : ip + 1; DISPATCH(); } while (0)
+// Used to step a, then branch to c if the comparison with d holds (skipping the fused branch otherwise).
+#define STEP_BRANCH(step, cmp) do { s[ip->a] = step(s[ip->a], s[ip->b]); ip = s[ip->a] cmp s[ip->d] ? code + ip->c : ip + 2; DISPATCH(); } while (0)
+
+namespace {
+
+// Arithmetic wraps around like the machine one (signed overflow is undefined in C++).
+inline int64_t wrap_add(int64_t a, int64_t b) { return (int64_t) ((uint64_t) a + (uint64_t) b); }
+inline int64_t wrap_sub(int64_t a, int64_t b) { return (int64_t) ((uint64_t) a - (uint64_t) b); }
+inline int64_t wrap_mul(int64_t a, int64_t b) { return (int64_t) ((uint64_t) a * (uint64_t) b); }
+inline int64_t wrap_shl(int64_t a, int64_t b) { return (int64_t) ((uint64_t) a << (b & 63)); }
+
+// Interpreter loop, the profiling one counts every pair of executed opcodes.
+template <bool PROFILE>
+int64_t execute(const Bytecode &bytecode, std::vector<int64_t> &slots, Bc_Profile *pairs) {
+    if (slots.size() != bytecode.slots.size()) crash("Wrong number of slots for the bytecode.\n");
+    if (bytecode.code.empty()) return 0;
+
+    const Bc_Instr *code = bytecode.code.data();
+    const Bc_Instr *ip = code;
+    int64_t *s = slots.data();
+
+    // opcode executed last (none yet).
+    int prev = -1;
+    auto count = [&](Bc_Op op) {
+        if (prev >= 0) (*pairs)[prev][(int) op]++;
+        prev = (int) op;
+    };
+    (void) count;
+
+#if XT_THREADED
+    // same order as Bc_Op.
+    static const void *HANDLERS[BC_OP_COUNT] = {
+        &&do_MOV, &&do_ADD, &&do_SUB, &&do_MUL, &&do_SHL, &&do_JMP,
+        &&do_BR_EQU, &&do_BR_NEQU, &&do_BR_LTH, &&do_BR_LTE, &&do_BR_GT, &&do_BR_GTE,
+        &&do_EXIT,
+        &&do_ADD_BR_EQU, &&do_ADD_BR_NEQU, &&do_ADD_BR_LTH, &&do_ADD_BR_LTE, &&do_ADD_BR_GT, &&do_ADD_BR_GTE,
+        &&do_SUB_BR_EQU, &&do_SUB_BR_NEQU, &&do_SUB_BR_LTH, &&do_SUB_BR_LTE, &&do_SUB_BR_GT, &&do_SUB_BR_GTE,
+        &&do_ADD_JMP, &&do_SUB_JMP, &&do_MOV_MOV,
+    };
+
+    DISPATCH();
+    {
+#else
+    for (;;) switch (ip->op) {
+#endif
+        HANDLER(MOV) s[ip->a] = s[ip->b]; NEXT();
+        HANDLER(ADD) s[ip->a] = wrap_add(s[ip->a], s[ip->b]); NEXT();
+        HANDLER(SUB) s[ip->a] = wrap_sub(s[ip->a], s[ip->b]); NEXT();
+        HANDLER(MUL) s[ip->a] = wrap_mul(s[ip->a], s[ip->b]); NEXT();
+        HANDLER(SHL) s[ip->a] = wrap_shl(s[ip->a], s[ip->b]); NEXT();
+        HANDLER(JMP) ip = code + ip->c; DISPATCH();
+        HANDLER(BR_EQU) BRANCH(==);
+        HANDLER(BR_NEQU) BRANCH(!=);
+        HANDLER(BR_LTH) BRANCH(<);
+        HANDLER(BR_LTE) BRANCH(<=);
+        HANDLER(BR_GT) BRANCH(>);
+        HANDLER(BR_GTE) BRANCH(>=);
+        HANDLER(EXIT) return s[ip->a];
+
+        HANDLER(ADD_BR_EQU) STEP_BRANCH(wrap_add, ==);
+        HANDLER(ADD_BR_NEQU) STEP_BRANCH(wrap_add, !=);
+        HANDLER(ADD_BR_LTH) STEP_BRANCH(wrap_add, <);
+        HANDLER(ADD_BR_LTE) STEP_BRANCH(wrap_add, <=);
+        HANDLER(ADD_BR_GT) STEP_BRANCH(wrap_add, >);
+        HANDLER(ADD_BR_GTE) STEP_BRANCH(wrap_add, >=);
+        HANDLER(SUB_BR_EQU) STEP_BRANCH(wrap_sub, ==);
+        HANDLER(SUB_BR_NEQU) STEP_BRANCH(wrap_sub, !=);
+        HANDLER(SUB_BR_LTH) STEP_BRANCH(wrap_sub, <);
+        HANDLER(SUB_BR_LTE) STEP_BRANCH(wrap_sub, <=);
+        HANDLER(SUB_BR_GT) STEP_BRANCH(wrap_sub, >);
+        HANDLER(SUB_BR_GTE) STEP_BRANCH(wrap_sub, >=);
+        HANDLER(ADD_JMP) s[ip->a] = wrap_add(s[ip->a], s[ip->b]); ip = code + ip->c; DISPATCH();
+        HANDLER(SUB_JMP) s[ip->a] = wrap_sub(s[ip->a], s[ip->b]); ip = code + ip->c; DISPATCH();
+        HANDLER(MOV_MOV) s[ip->a] = s[ip->b]; s[ip->c] = s[ip->d]; ip += 2; DISPATCH();
+    }
+
+    return 0;
+}
+
+}
+
+int64_t interpret(const Bytecode &bytecode, std::vector<int64_t> &slots) {
+    return execute<false>(bytecode, slots, nullptr);
+}
+
+int64_t profile(const Bytecode &bytecode, std::vector<int64_t> &slots, Bc_Profile &pairs) {
+    if (pairs.size() != BC_OP_COUNT) pairs.assign(BC_OP_COUNT, {});
+    return execute<true>(bytecode, slots, &pairs);
+}